@@ -1,4 +1,15 @@
 #include "AStarSearch.h"
+#include "AnyAngleSearch.h"
+#include "BidirectionalSearch.h"
+#include "FirstMoveTable.h"
+#include "GoalBounds.h"
+#include "IndexedHeap.h"
+#include "JumpPointSearch.h"
+#include "LandmarkHeuristic.h"
+#include "Pathfinder.h"
+#include "RectangleGraph.h"
+#include "SubgoalGraph.h"
+#include "WeightedSearch.h"
 #include <queue>
 #include <iostream>
 #include <fstream>
@@ -6,14 +17,8 @@
 // checks if player can move to position
 bool isValid(const Map& theMap, int x, int y)
 {
-	if (x < 0 || x >= 32) return false;
-	if (y < 0 || y >= 24) return false;
-
-	// block walls (1) and breakables (3)
-	int t = theMap[y][x];
-	if (t == 1 || t == 3) return false;
-
-	return true;
+	// block walls (1), breakables (3) and anything off the map
+	return !theMap.isBlocked(x, y);
 }
 
 // Indicates if the position x,y corresponds to the destination
@@ -25,6 +30,13 @@ bool isDestination(int x, int y, Node destination)
 	return false;
 }
 
+bool isUnreachable(const Map& theMap, const Node& start, const Node& dest)
+{
+	// a blocked start (e.g. standing in a just-placed wall) still gets searched
+	int from = theMap.getRegion(start.x, start.y);
+	return from != -1 && from != theMap.getRegion(dest.x, dest.y);
+}
+
 float calculateH(int x, int y, Node destination)
 {
 	int xDist = max(x, destination.x) - min(x, destination.x);
@@ -33,105 +45,184 @@ float calculateH(int x, int y, Node destination)
 	return xDist + yDist;
 }
 
-//works out pathing
-vector<Node> makePath(array<array<Node, 32>, 24>& map, Node dest)
+// Works out pathing by following parents back from dest. The length is
+// known up front (dest's g-cost), so each tile goes straight into its slot
+// and no reversing is needed.
+void makePath(const SearchContext& context, int destTile, TilePath& path)
 {
-	// Stores the path
-	vector<Node> usablePath;
+	const int width = context.getWidth();
+	path.reset(width, context.getG(destTile) + 1);
+
+	int tile = destTile;
+
+	while (true) {
+		const int parentTile = context.getParent(tile);
+
+		// parent links can jump along a straight line; fill in the tiles between
+		int x = tile % width;
+		int y = tile / width;
+		const int px = parentTile % width;
+		const int py = parentTile / width;
+		const int dx = (px > x) - (px < x);
+		const int dy = (py > y) - (py < y);
+
+		int i = context.getG(tile);
+		while (true) {
+			path.set(i, y * width + x);
+			if (x == px && y == py) break;
+
+			x += dx;
+			y += dy;
+			i--;
+		}
+
+		// the start is its own parent
+		if (parentTile == tile) break;
 
-	// Start at the destination
-	int x = dest.x;
-	int y = dest.y;
+		// Move to parent for next repetition
+		tile = parentTile;
+	}
+}
 
-	//finds required nodes to make path
-	while (!(map[y][x].parentX == x && map[y][x].parentY == y)
-		&& map[y][x].x != -1 && map[y][x].y != -1)
-	{
-		// Put the node in the list
-		usablePath.push_back(map[y][x]);
+vector<Node> makePath(const SearchContext& context, Node dest)
+{
+	TilePath path;
+	makePath(context, dest.y * context.getWidth() + dest.x, path);
+	return toNodes(path);
+}
 
-		int tempX = map[y][x].parentX;
-		int tempY = map[y][x].parentY;
+vector<Node> toNodes(const TilePath& path)
+{
+	vector<Node> usablePath(path.size());
+	if (usablePath.empty()) return usablePath;
+
+	Node goal;
+	goal.x = path.xAt(path.size() - 1);
+	goal.y = path.yAt(path.size() - 1);
+
+	for (int i = 0; i < path.size(); i++) {
+		Node& n = usablePath[i];
+		n.x = path.xAt(i);
+		n.y = path.yAt(i);
+		n.parentX = i > 0 ? path.xAt(i - 1) : n.x;
+		n.parentY = i > 0 ? path.yAt(i - 1) : n.y;
+		n.gCost = (float)i;
+		n.hCost = calculateH(n.x, n.y, goal);
+		n.fCost = n.gCost + n.hCost;
+	}
+	return usablePath;
+}
 
-		// Move to parent for next repetition
-		x = tempX;
-		y = tempY;
+void assignNodes(TilePath& path, const vector<Node>& nodes, int width)
+{
+	path.reset(width, (int)nodes.size());
+	for (size_t i = 0; i < nodes.size(); i++) {
+		path.set((int)i, nodes[i].y * width + nodes[i].x);
 	}
+}
 
-	// Push the start node into the list
-	usablePath.push_back(map[y][x]);
+// Default scratch state for callers that don't bring their own.
+// One per thread, so concurrent searches never share it.
+static thread_local SearchContext defaultContext;
 
-	// Reverse the list so in start to dest order
-	reverse(usablePath.begin(), usablePath.end());
+// backward half of bidirectional searches run through findPath()
+static thread_local SearchContext backwardContext;
 
-	return usablePath;
+// Manhattan distance, raised to the landmark bound when there are tables
+static float estimate(const LandmarkHeuristic* landmarks, int tile, int x, int y, int destTile, const Node& dest)
+{
+	float h = calculateH(x, y, dest);
+	if (landmarks) {
+		h = max(h, (float)landmarks->lowerBound(tile, destTile));
+	}
+	return h;
 }
 
+// Offer neighbour (nx, ny) a route through tile
+static void relaxNeighbour(SearchContext& context, const Map& theMap, int tile, int nx, int ny, const Node& dest,
+	const LandmarkHeuristic* landmarks, int destTile)
+{
+	if (!isValid(theMap, nx, ny)) return;
+
+	const int next = ny * context.getWidth() + nx;
+	if (context.isClosed(next)) return;
+
+	const int32_t gNew = context.getG(tile) + 1;
 
-array<array<Node, 32>, 24> nodeDetails;
+	if (!context.isSeen(next) || context.getG(next) > gNew) {
+		const float hNew = estimate(landmarks, next, nx, ny, destTile, dest);
 
-array<array<bool, 32>, 24> closedList;
+		context.setNode(next, gNew, tile);
+		context.openList.push(next, gNew + hNew, hNew);
+	}
+}
+
+
+vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest)
+{
+	return aStar(theMap, player, dest, defaultContext);
+}
 
-vector<Node> emptyPath;
+vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest, SearchContext& context)
+{
+	TilePath path;
+	aStar(theMap, player, dest, context, path);
+	return toNodes(path);
+}
 
+bool aStar(const Map& theMap, const Node& player, const Node& dest, SearchContext& context, TilePath& path)
+{
+	path.clear();
 
-vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest) {
 	if (!isValid(theMap, dest.x, dest.y)) {
-		return emptyPath;
+		return false;
 	}
 
 	if (isDestination(player.x, player.y, dest)) {
-		return emptyPath;
+		return false;
 	}
 
-	// Initialise the helper arrays
-	for (int y = 0; y < 24; y++) {
-		for (int x = 0; x < 32; x++) {
+	if (isUnreachable(theMap, player, dest)) {
+		return false;
+	}
 
-			nodeDetails[y][x].x = x;
-			nodeDetails[y][x].y = y;
+	const int width = theMap.getWidth();
 
-			nodeDetails[y][x].fCost = FLT_MAX;
-			nodeDetails[y][x].gCost = FLT_MAX;
-			nodeDetails[y][x].hCost = FLT_MAX;
+	// O(1): anything not stamped by this search counts as unvisited
+	context.begin(width, theMap.getHeight());
 
-			nodeDetails[y][x].parentX = -1;
-			nodeDetails[y][x].parentY = -1;
-			closedList[y][x] = false;
-		}
-	}
+	// Landmark tables from before a tile broke could overestimate
+	const LandmarkHeuristic* landmarks = theMap.getLandmarks();
+	if (landmarks && !landmarks->isCurrent(theMap)) landmarks = nullptr;
 
-	// list of nodes to visit
-	vector<Node> openList;
+	// so could goal bounds, which would then prune too much
+	const GoalBounds* bounds = theMap.getGoalBounds();
+	if (bounds && !bounds->isCurrent(theMap)) bounds = nullptr;
 
 	// Initialise the starting point to the player position
-	nodeDetails[player.y][player.x].x = player.x;
-	nodeDetails[player.y][player.x].y = player.y;
-	nodeDetails[player.y][player.x].fCost = 0.0f;
-	nodeDetails[player.y][player.x].gCost = 0.0f;
-	nodeDetails[player.y][player.x].hCost = 0.0f;
-	nodeDetails[player.y][player.x].parentX = player.x;
-	nodeDetails[player.y][player.x].parentY = player.y;
+	const int startTile = player.y * width + player.x;
+	const int destTile = dest.y * width + dest.x;
+	context.setNode(startTile, 0, startTile);
 
 	// Put the start node into the open list to start the algorithm
-	openList.push_back(nodeDetails[player.y][player.x]);
+	const float hStart = estimate(landmarks, startTile, player.x, player.y, destTile, dest);
+	context.openList.push(startTile, hStart, hStart);
 
 	// Indicates if the destination was found.
 	bool found = false;
 
 	// While there are nodes to process
-	while (!openList.empty()) {
-		// Get one from the list
-		Node current = openList.front();
-
-		// Remove it from the list so it isn't processed again
-		openList.erase(openList.begin());
+	while (!context.openList.empty()) {
+		// Take the cheapest node, removing it so it isn't processed again
+		const int tile = context.openList.pop();
+		const int x = tile % width;
+		const int y = tile / width;
 
 		// Indicate visited
-		closedList[current.y][current.x] = true;
+		context.close(tile);
 
 		// Is the node the destination?
-		if (isDestination(current.x, current.y, dest)) {
+		if (isDestination(x, y, dest)) {
 			// Indicate found it if it is
 			found = true;
 
@@ -139,87 +230,110 @@ vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest) {
 			break;
 		}
 
-	    //checks surrounding
-		if (isValid(theMap, current.x, current.y - 1) && !closedList[current.y - 1][current.x]) {
-			float gNew = nodeDetails[current.y][current.x].gCost + 1.0f;
-			float hNew = calculateH(current.x, current.y - 1, dest);
-			float fNew = gNew + hNew;
-
-			if (nodeDetails[current.y - 1][current.x].fCost == FLT_MAX || nodeDetails[current.y - 1][current.x].fCost > fNew) {
-
-				nodeDetails[current.y - 1][current.x].fCost = fNew;
-				nodeDetails[current.y - 1][current.x].gCost = gNew;
-				nodeDetails[current.y - 1][current.x].hCost = hNew;
-				nodeDetails[current.y - 1][current.x].parentX = current.x;
-				nodeDetails[current.y - 1][current.x].parentY = current.y;
-
-				openList.push_back(nodeDetails[current.y - 1][current.x]);
-			}
-		}
-
-		// Right
-		if (isValid(theMap, current.x + 1, current.y) && !closedList[current.y][current.x + 1]) {
-			float gNew = nodeDetails[current.y][current.x].gCost + 1.0f;
-			float hNew = calculateH(current.x + 1, current.y, dest);
-			float fNew = gNew + hNew;
-
-			if (nodeDetails[current.y][current.x + 1].fCost == FLT_MAX || nodeDetails[current.y][current.x + 1].fCost > fNew) {
-	
-				nodeDetails[current.y][current.x + 1].fCost = fNew;
-				nodeDetails[current.y][current.x + 1].gCost = gNew;
-				nodeDetails[current.y][current.x + 1].hCost = hNew;
-				nodeDetails[current.y][current.x + 1].parentX = current.x;
-				nodeDetails[current.y][current.x + 1].parentY = current.y;
-
-				openList.push_back(nodeDetails[current.y][current.x + 1]);
-			}
-		}
-
-		// Down
-		if (isValid(theMap, current.x, current.y + 1) && !closedList[current.y + 1][current.x]) {
-			float gNew = nodeDetails[current.y][current.x].gCost + 1.0f;
-			float hNew = calculateH(current.x, current.y + 1, dest);
-			float fNew = gNew + hNew;
-
-			if (nodeDetails[current.y + 1][current.x].fCost == FLT_MAX || nodeDetails[current.y + 1][current.x].fCost > fNew) {
-
-				nodeDetails[current.y + 1][current.x].fCost = fNew;
-				nodeDetails[current.y + 1][current.x].gCost = gNew;
-				nodeDetails[current.y + 1][current.x].hCost = hNew;
-				nodeDetails[current.y + 1][current.x].parentX = current.x;
-				nodeDetails[current.y + 1][current.x].parentY = current.y;
-
-				openList.push_back(nodeDetails[current.y + 1][current.x]);
-			}
-		}
-
-		// Left
-		if (isValid(theMap, current.x - 1, current.y) && !closedList[current.y][current.x - 1]) {
-			float gNew = nodeDetails[current.y][current.x].gCost + 1.0f;
-			float hNew = calculateH(current.x - 1, current.y, dest);
-			float fNew = gNew + hNew;
-
-			if (nodeDetails[current.y][current.x - 1].fCost == FLT_MAX || nodeDetails[current.y][current.x - 1].fCost > fNew) {
-
-				nodeDetails[current.y][current.x - 1].fCost = fNew;
-				nodeDetails[current.y][current.x - 1].gCost = gNew;
-				nodeDetails[current.y][current.x - 1].hCost = hNew;
-				nodeDetails[current.y][current.x - 1].parentX = current.x;
-				nodeDetails[current.y][current.x - 1].parentY = current.y;
-
-				openList.push_back(nodeDetails[current.y][current.x - 1]);
-			}
-		}
-
+		//checks surrounding: up, right, down, left
+		if (!bounds || bounds->mayLeadTo(tile, 0, dest.x, dest.y)) relaxNeighbour(context, theMap, tile, x, y - 1, dest, landmarks, destTile);
+		if (!bounds || bounds->mayLeadTo(tile, 1, dest.x, dest.y)) relaxNeighbour(context, theMap, tile, x + 1, y, dest, landmarks, destTile);
+		if (!bounds || bounds->mayLeadTo(tile, 2, dest.x, dest.y)) relaxNeighbour(context, theMap, tile, x, y + 1, dest, landmarks, destTile);
+		if (!bounds || bounds->mayLeadTo(tile, 3, dest.x, dest.y)) relaxNeighbour(context, theMap, tile, x - 1, y, dest, landmarks, destTile);
 	}
 
 	// Out of loop.  Was the destination found?
 	if (found) {
 		// Yes, then create the path for the current node state
-		return makePath(nodeDetails, dest);
+		makePath(context, destTile, path);
 	}
-	else {
-		// No, return no path
-		return emptyPath;
+	return found;
+}
+
+bool isShortestTileMode(SearchMode mode)
+{
+	return mode != SearchMode::Weighted && mode != SearchMode::Octile && mode != SearchMode::AnyAngle;
+}
+
+vector<Node> findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode)
+{
+	return findPath(theMap, start, dest, mode, defaultContext);
+}
+
+vector<Node> findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode, SearchContext& context)
+{
+	switch (mode) {
+	case SearchMode::JumpPoint:
+		return jumpPointSearch(theMap, start, dest, context);
+	case SearchMode::Bidirectional: {
+		TilePath path;
+		bidirectionalAStar(theMap, start, dest, context, backwardContext, path);
+		return toNodes(path);
+	}
+	case SearchMode::Weighted: {
+		TilePath path;
+		dialSearch(theMap, start, dest, context, path);
+		return toNodes(path);
+	}
+	case SearchMode::Specialized: {
+		TilePath path;
+		specializedAStar(theMap, start, dest, path);
+		return toNodes(path);
+	}
+	case SearchMode::Subgoal: {
+		TilePath path;
+		subgoalSearch(theMap, start, dest, context, path);
+		return toNodes(path);
+	}
+	case SearchMode::Rectangles: {
+		TilePath path;
+		rectangleSearch(theMap, start, dest, context, path);
+		return toNodes(path);
+	}
+	case SearchMode::Octile: {
+		TilePath path;
+		octileAStar(theMap, start, dest, path);
+		return toNodes(path);
+	}
+	case SearchMode::AnyAngle: {
+		TilePath path;
+		thetaStar(theMap, start, dest, context, path);
+		return toNodes(path);
+	}
+	case SearchMode::FirstMove: {
+		TilePath path;
+		firstMoveSearch(theMap, start, dest, context, path);
+		return toNodes(path);
+	}
+	case SearchMode::AStar:
+	default:
+		return aStar(theMap, start, dest, context);
+	}
+}
+
+bool findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode, TilePath& path)
+{
+	return findPath(theMap, start, dest, mode, defaultContext, path);
+}
+
+bool findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode, SearchContext& context, TilePath& path)
+{
+	switch (mode) {
+	case SearchMode::JumpPoint:
+		return jumpPointSearch(theMap, start, dest, context, path);
+	case SearchMode::Bidirectional:
+		return bidirectionalAStar(theMap, start, dest, context, backwardContext, path);
+	case SearchMode::Weighted:
+		return dialSearch(theMap, start, dest, context, path);
+	case SearchMode::Specialized:
+		return specializedAStar(theMap, start, dest, path);
+	case SearchMode::Subgoal:
+		return subgoalSearch(theMap, start, dest, context, path);
+	case SearchMode::Rectangles:
+		return rectangleSearch(theMap, start, dest, context, path);
+	case SearchMode::Octile:
+		return octileAStar(theMap, start, dest, path);
+	case SearchMode::AnyAngle:
+		return thetaStar(theMap, start, dest, context, path);
+	case SearchMode::FirstMove:
+		return firstMoveSearch(theMap, start, dest, context, path);
+	case SearchMode::AStar:
+	default:
+		return aStar(theMap, start, dest, context, path);
 	}
 }
\ No newline at end of file
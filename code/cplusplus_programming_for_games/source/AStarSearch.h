@@ -4,7 +4,10 @@
 #include <vector>
 #include <array>
 #include <stack>
+#include "Grid.h"
 #include "Map.h"
+#include "SearchContext.h"
+#include "TilePath.h"
 
 using namespace std;
 
@@ -16,13 +19,74 @@ struct Node {
 	float fCost; 
 };
 
-bool isValid(Map& map, int x, int y);
+bool isValid(const Map& map, int x, int y);
 
 bool isDestination(int x, int y, Node destination);
 
+// True when start and dest are in different connected regions of the map,
+// so no search can join them. Costs two lookups.
+bool isUnreachable(const Map& map, const Node& start, const Node& dest);
+
 float calculateH(int x, int y, Node destination);
 
-vector<Node> makePath(array<array<Node, 32>, 24>& map, Node dest);
+// Path from the search's start to destTile, written in order into path
+void makePath(const SearchContext& context, int destTile, TilePath& path);
+vector<Node> makePath(const SearchContext& context, Node dest);
+
+// Conversions for code that still works with vector<Node> paths
+vector<Node> toNodes(const TilePath& path);
+void assignNodes(TilePath& path, const vector<Node>& nodes, int width);
+
+// Main A* algorithm. The context holds all scratch state, so searches with
+// different contexts can run on different threads at once. The overloads
+// without one use a per-thread default.
+// If the map has current landmark tables (Map::setLandmarks) they tighten
+// the Manhattan estimate, and current goal bounds (Map::setGoalBounds) keep
+// it off neighbours no shortest path to dest goes through.
+vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest);
+vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest, SearchContext& context);
+
+// As above, writing into a caller-owned path; false (and an empty path) if
+// there is no route. No allocation once path and context have grown.
+bool aStar(const Map& theMap, const Node& player, const Node& dest, SearchContext& context, TilePath& path);
+
+// Which search findPath() runs. All modes but AnyAngle return a
+// tile-by-tile path; all but Weighted, Octile and AnyAngle the same shortest
+// one. Weighted is the cheapest by move cost (dialSearch() in
+// WeightedSearch.h), which may go through breakables.
+// Specialized is A* compiled for the map's size (specializedAStar() in
+// Pathfinder.h). Subgoal searches the map's corner graph (subgoalSearch()
+// in SubgoalGraph.h), Rectangles its empty-rectangle cover
+// (rectangleSearch() in RectangleGraph.h).
+// Octile also steps diagonally (octileAStar() in Pathfinder.h). AnyAngle
+// returns only the tiles the route turns at, joined by straight lines an
+// agent can walk (thetaStar() in AnyAngleSearch.h). FirstMove follows the
+// map's first-move table without searching (firstMoveSearch() in
+// FirstMoveTable.h).
+enum class SearchMode {
+	AStar,
+	JumpPoint,
+	Bidirectional,
+	Weighted,
+	Specialized,
+	Subgoal,
+	Rectangles,
+	Octile,
+	AnyAngle,
+	FirstMove
+};
+
+// Number of modes, for code that packs one into a few bits. FirstMove must
+// stay the last mode, or this must move with it.
+const int SEARCH_MODE_COUNT = (int)SearchMode::FirstMove + 1;
+
+// True for the modes that all return aStar()'s shortest 4-connected path,
+// so a cached path or hierarchical leg can stand in
+bool isShortestTileMode(SearchMode mode);
 
-// Main A* algorithm
-vector<Node> aStar(const Map& theMap, const Node& player, const Node& dest);
\ No newline at end of file
+// The context-taking overloads run a bidirectional search's forward half in
+// the given context and its backward half in a per-thread one.
+vector<Node> findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode);
+vector<Node> findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode, SearchContext& context);
+bool findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode, TilePath& path);
+bool findPath(const Map& theMap, const Node& start, const Node& dest, SearchMode mode, SearchContext& context, TilePath& path);
\ No newline at end of file
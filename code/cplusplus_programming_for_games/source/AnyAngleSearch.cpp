@@ -0,0 +1,162 @@
+#include "AnyAngleSearch.h"
+#include <cmath>
+#include <cstdint>
+
+// Lazy Theta*: a tile reached from s is given s's parent straight away, on
+// the assumption it can see it. The line is only checked when the tile is
+// expanded, once per expansion instead of once per neighbour, and if it's
+// blocked the tile falls back to the best of its closed neighbours.
+
+// g-costs are distances in 1/UNIT tiles, to fit SearchContext's integers
+static const int32_t UNIT = 1024;
+
+// up, right, down, left, then up-right, down-right, down-left, up-left
+static const int DIR_X[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+static const int DIR_Y[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+static thread_local SearchContext defaultContext;
+
+static int32_t distance(int x0, int y0, int x1, int y1)
+{
+	const float dx = (float)(x1 - x0);
+	const float dy = (float)(y1 - y0);
+	return (int32_t)(std::sqrt(dx * dx + dy * dy) * UNIT + 0.5f);
+}
+
+// Bit d set for each direction a step from (x, y) can go without leaving
+// the map, entering a blocked tile or cutting a wall corner
+static unsigned stepMask(const Map& theMap, int x, int y)
+{
+	unsigned mask = 0;
+	for (int d = 0; d < 4; d++) {
+		if (isValid(theMap, x + DIR_X[d], y + DIR_Y[d])) mask |= 1u << d;
+	}
+
+	// a diagonal needs the straight steps either side of it
+	for (int d = 4; d < 8; d++) {
+		const int side = (mask >> (d - 4)) & (mask >> ((d - 3) & 3)) & 1;
+		if (side && isValid(theMap, x + DIR_X[d], y + DIR_Y[d])) mask |= 1u << d;
+	}
+	return mask;
+}
+
+bool lineOfSight(const Map& theMap, int x0, int y0, int x1, int y1)
+{
+	// the walker is already on the first tile, even if it's since been blocked
+	return forEachTileOnLine(x0, y0, x1, y1, [&](int x, int y) {
+		return (x == x0 && y == y0) || isValid(theMap, x, y);
+	});
+}
+
+vector<Node> thetaStar(const Map& theMap, const Node& start, const Node& dest)
+{
+	TilePath path;
+	thetaStar(theMap, start, dest, defaultContext, path);
+	return toNodes(path);
+}
+
+bool thetaStar(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path)
+{
+	path.clear();
+
+	if (!isValid(theMap, dest.x, dest.y)) {
+		return false;
+	}
+
+	if (isDestination(start.x, start.y, dest)) {
+		return false;
+	}
+
+	if (isUnreachable(theMap, start, dest)) {
+		return false;
+	}
+
+	const int width = theMap.getWidth();
+	context.begin(width, theMap.getHeight());
+
+	const int startTile = start.y * width + start.x;
+	const int destTile = dest.y * width + dest.x;
+	context.setNode(startTile, 0, startTile);
+
+	const float hStart = (float)distance(start.x, start.y, dest.x, dest.y);
+	context.openList.push(startTile, hStart, hStart);
+
+	bool found = false;
+
+	while (!context.openList.empty()) {
+		const int tile = context.openList.pop();
+		const int x = tile % width;
+		const int y = tile / width;
+
+		// Check the line to the parent we assumed. If it's blocked, come
+		// from whichever closed neighbour is cheapest; the one that offered
+		// this tile is closed, so there always is one.
+		const unsigned steps = stepMask(theMap, x, y);
+
+		int parentTile = context.getParent(tile);
+		if (tile != startTile && !lineOfSight(theMap, parentTile % width, parentTile / width, x, y)) {
+			int32_t best = INT32_MAX;
+			for (int d = 0; d < 8; d++) {
+				if (!(steps >> d & 1)) continue;
+
+				const int next = (y + DIR_Y[d]) * width + x + DIR_X[d];
+				if (!context.isClosed(next)) continue;
+
+				const int32_t g = context.getG(next) + (d < 4 ? UNIT : distance(0, 0, 1, 1));
+				if (g < best) {
+					best = g;
+					parentTile = next;
+				}
+			}
+			context.setNode(tile, best, parentTile);
+		}
+
+		context.close(tile);
+
+		if (tile == destTile) {
+			found = true;
+			break;
+		}
+
+		// Neighbours are offered a straight line from this tile's parent
+		const int px = parentTile % width;
+		const int py = parentTile / width;
+		const int32_t gParent = context.getG(parentTile);
+
+		for (int d = 0; d < 8; d++) {
+			if (!(steps >> d & 1)) continue;
+
+			const int nx = x + DIR_X[d];
+			const int ny = y + DIR_Y[d];
+			const int next = ny * width + nx;
+			if (context.isClosed(next)) continue;
+
+			const int32_t gNew = gParent + distance(px, py, nx, ny);
+
+			if (!context.isSeen(next) || context.getG(next) > gNew) {
+				const float hNew = (float)distance(nx, ny, dest.x, dest.y);
+
+				context.setNode(next, gNew, parentTile);
+				context.openList.push(next, gNew + hNew, hNew);
+			}
+		}
+	}
+
+	if (!found) return false;
+
+	// Parents back from dest are the turning points; count them first and
+	// fill from the back
+	int length = 1;
+	for (int tile = destTile; tile != startTile; tile = context.getParent(tile)) {
+		length++;
+	}
+
+	path.reset(width, length);
+
+	int tile = destTile;
+	for (int i = length - 1; i >= 0; i--) {
+		path.set(i, tile);
+		tile = context.getParent(tile);
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdlib>
+#include <vector>
+#include "AStarSearch.h"
+
+using namespace std;
+
+// Any-angle paths (lazy Theta*). The search runs over the 8-connected grid,
+// but a tile takes its parent's parent as its own whenever there's a
+// straight line between the two, so the path comes back as the few tiles it
+// turns at, usually wall corners, rather than every tile on the way.
+//
+// Walking from each tile's centre straight to the next never enters a
+// blocked tile, nor squeezes between two blocked tiles that touch at a
+// corner. Paths are close to, but not always exactly, the shortest
+// Euclidean route. A path is empty (false) exactly when aStar()'s would be.
+vector<Node> thetaStar(const Map& theMap, const Node& start, const Node& dest);
+bool thetaStar(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path);
+
+// True if an agent can walk straight from the centre of (x0, y0) to the
+// centre of (x1, y1): every tile the line passes through after (x0, y0) is
+// open, and where it passes exactly through a corner both tiles beside it are
+bool lineOfSight(const Map& theMap, int x0, int y0, int x1, int y1);
+
+// Call visit(x, y) for each tile the line between the centres of (x0, y0)
+// and (x1, y1) passes through, in order from (x0, y0), stopping early if it
+// returns false. Where the line goes exactly through a corner, both tiles
+// beside it are visited. Returns false if visit did.
+template <typename Visit>
+bool forEachTileOnLine(int x0, int y0, int x1, int y1, Visit visit)
+{
+	int dx = abs(x1 - x0);
+	int dy = abs(y1 - y0);
+	const int stepX = x1 > x0 ? 1 : -1;
+	const int stepY = y1 > y0 ? 1 : -1;
+
+	// Which tile border the line crosses next: error > 0 a vertical one,
+	// error < 0 a horizontal one, 0 both at once (a corner)
+	int error = dx - dy;
+	dx *= 2;
+	dy *= 2;
+
+	int x = x0;
+	int y = y0;
+	for (int n = 1 + abs(x1 - x0) + abs(y1 - y0); n > 0; n--) {
+		if (!visit(x, y)) return false;
+
+		if (error > 0) {
+			x += stepX;
+			error -= dy;
+		}
+		else {
+			// the loop visits the tile below the corner next; this is the
+			// one beside it
+			if (error == 0 && n > 1 && !visit(x + stepX, y)) return false;
+
+			y += stepY;
+			error += dx;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,129 @@
+#include "BidirectionalSearch.h"
+#include <climits>
+
+static thread_local SearchContext defaultForward;
+static thread_local SearchContext defaultBackward;
+
+// Expand tile on one side of the search. A neighbour the other side has
+// already reached completes a route; keep it if it beats best.
+static void expandTile(const Map& theMap, SearchContext& side, const SearchContext& other, int tile,
+	const Node& target, int& best, int& meet)
+{
+	// up, right, down, left
+	static const int DIR_X[4] = { 0, 1, 0, -1 };
+	static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+	const int width = side.getWidth();
+	const int x = tile % width;
+	const int y = tile / width;
+
+	for (int d = 0; d < 4; d++) {
+		const int nx = x + DIR_X[d];
+		const int ny = y + DIR_Y[d];
+		if (!isValid(theMap, nx, ny)) continue;
+
+		const int next = ny * width + nx;
+		if (side.isClosed(next)) continue;
+
+		const int32_t gNew = side.getG(tile) + 1;
+
+		if (!side.isSeen(next) || side.getG(next) > gNew) {
+			const float hNew = calculateH(nx, ny, target);
+
+			side.setNode(next, gNew, tile);
+			side.openList.push(next, gNew + hNew, hNew);
+
+			if (other.isSeen(next) && gNew + other.getG(next) < best) {
+				best = gNew + other.getG(next);
+				meet = next;
+			}
+		}
+	}
+}
+
+vector<Node> bidirectionalAStar(const Map& theMap, const Node& start, const Node& dest)
+{
+	TilePath path;
+	bidirectionalAStar(theMap, start, dest, defaultForward, defaultBackward, path);
+	return toNodes(path);
+}
+
+bool bidirectionalAStar(const Map& theMap, const Node& start, const Node& dest,
+	SearchContext& forward, SearchContext& backward, TilePath& path)
+{
+	path.clear();
+
+	if (!isValid(theMap, dest.x, dest.y)) {
+		return false;
+	}
+
+	if (isDestination(start.x, start.y, dest)) {
+		return false;
+	}
+
+	if (isUnreachable(theMap, start, dest)) {
+		return false;
+	}
+
+	const int width = theMap.getWidth();
+	forward.begin(width, theMap.getHeight());
+	backward.begin(width, theMap.getHeight());
+
+	const int startTile = start.y * width + start.x;
+	const int destTile = dest.y * width + dest.x;
+
+	forward.setNode(startTile, 0, startTile);
+	const float hStart = calculateH(start.x, start.y, dest);
+	forward.openList.push(startTile, hStart, hStart);
+
+	backward.setNode(destTile, 0, destTile);
+	const float hDest = calculateH(dest.x, dest.y, start);
+	backward.openList.push(destTile, hDest, hDest);
+
+	// cheapest joined route so far, and the tile where the two halves meet
+	int best = INT_MAX;
+	int meet = -1;
+
+	while (!forward.openList.empty() && !backward.openList.empty()) {
+		// Manhattan distance is consistent, so every route not found yet
+		// costs at least the lowest f on either side
+		if (meet != -1 && (forward.openList.topF() >= best || backward.openList.topF() >= best)) {
+			break;
+		}
+
+		// grow whichever frontier is smaller
+		if (forward.openList.size() <= backward.openList.size()) {
+			const int tile = forward.openList.pop();
+			forward.close(tile);
+			expandTile(theMap, forward, backward, tile, dest, best, meet);
+		}
+		else {
+			const int tile = backward.openList.pop();
+			backward.close(tile);
+			expandTile(theMap, backward, forward, tile, start, best, meet);
+		}
+	}
+
+	if (meet == -1) {
+		return false;
+	}
+
+	// start..meet from the forward parents, meet..dest from the backward ones
+	path.reset(width, best + 1);
+
+	int tile = meet;
+	while (true) {
+		path.set(forward.getG(tile), tile);
+		if (tile == startTile) break;
+		tile = forward.getParent(tile);
+	}
+
+	tile = meet;
+	while (true) {
+		path.set(best - backward.getG(tile), tile);
+		if (tile == destTile) break;
+		tile = backward.getParent(tile);
+	}
+
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+// Priority queue for small integer keys (Dial's algorithm): one bucket per
+// key, used as a ring. With a consistent heuristic and integer move costs,
+// every key pushed is within `span` of the lowest key still queued, so
+// span buckets are enough and push / pop are O(1).
+// A tile can be pushed again with a lower key; the old entry stays behind
+// and the search skips it when it comes out (check isClosed()).
+class BucketQueue {
+public:
+    // Empty the queue for keys that never run more than span - 1 ahead
+    void reset(int span)
+    {
+        if ((int)buckets.size() != span) buckets.resize(span);
+        for (std::vector<int>& b : buckets) b.clear();
+
+        lowest = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+
+    void push(int tile, int key)
+    {
+        if (count == 0 || key < lowest) lowest = key;
+
+        buckets[key % buckets.size()].push_back(tile);
+        count++;
+    }
+
+    // Removes and returns a tile with the lowest key, or -1 if the queue is
+    // empty. Within a bucket the newest comes out first, which favours tiles
+    // nearer the goal.
+    int pop()
+    {
+        if (count == 0) return -1;
+        skipEmpty();
+
+        std::vector<int>& b = buckets[lowest % buckets.size()];
+        int tile = b.back();
+        b.pop_back();
+        count--;
+        return tile;
+    }
+
+private:
+    // Move lowest up to the next non-empty bucket. Only called with
+    // something queued, which is never more than span - 1 keys ahead.
+    void skipEmpty()
+    {
+        while (buckets[lowest % buckets.size()].empty()) lowest++;
+    }
+
+    std::vector<std::vector<int>> buckets;
+    int lowest = 0;
+    int count = 0;
+};
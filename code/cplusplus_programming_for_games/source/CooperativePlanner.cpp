@@ -0,0 +1,192 @@
+#include "CooperativePlanner.h"
+
+#include <algorithm>
+#include <chrono>
+
+// up, right, down, left, then wait
+static const int MOVE_X[5] = { 0, 1, 0, -1, 0 };
+static const int MOVE_Y[5] = { -1, 0, 1, 0, 0 };
+
+CooperativePlanner::CooperativePlanner(int window_, float budgetMs_)
+    : window(window_), budgetMs(budgetMs_)
+{
+}
+
+bool CooperativePlanner::plan(const Map& map, const CoopAgent* agents, CoopResult* results, int count, const Node& goal)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point started = Clock::now();
+
+    const int width = map.getWidth();
+    const int newGoal = goal.y * width + goal.x;
+
+    if (newGoal != goalTile || map.getVersion() != mapVersion) {
+        wavefront.distances(map.getWalkBits(), goal.x, goal.y, goalDistance);
+        goalTile = newGoal;
+        mapVersion = map.getVersion();
+    }
+
+    reservations.clear();
+
+    for (int i = 0; i < count; i++) {
+        results[i].planned = false;
+    }
+
+    // agents that missed out last round go first, then by priority
+    order.resize(count);
+    for (int i = 0; i < count; i++) order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const bool deferredA = deferredIds.count(agents[a].id) != 0;
+        const bool deferredB = deferredIds.count(agents[b].id) != 0;
+        if (deferredA != deferredB) return deferredA;
+        return agents[a].priority < agents[b].priority;
+    });
+
+    deferredIds.clear();
+
+    bool finished = true;
+
+    for (int k = 0; k < count; k++) {
+        const int i = order[k];
+
+        const float elapsed = std::chrono::duration<float, std::milli>(Clock::now() - started).count();
+        if (elapsed > budgetMs) {
+            for (int rest = k; rest < count; rest++) {
+                deferredIds.insert(agents[order[rest]].id);
+            }
+            stats.deferred += count - k;
+            finished = false;
+            break;
+        }
+
+        planAgent(map, agents[i], goalTile, results[i].path);
+        stats.expansions += context.getExpansions();
+        reserve(results[i].path, agents[i].id);
+        results[i].planned = true;
+        stats.planned++;
+    }
+
+    stats.rounds++;
+    stats.lastMs = std::chrono::duration<float, std::milli>(Clock::now() - started).count();
+    stats.worstMs = std::max(stats.worstMs, stats.lastMs);
+    if (!finished) stats.overBudgetRounds++;
+
+    return finished;
+}
+
+bool CooperativePlanner::planAgent(const Map& map, const CoopAgent& agent, int goal, TilePath& path)
+{
+    const int width = map.getWidth();
+    const int tileCount = width * map.getHeight();
+    const int startTile = agent.start.y * width + agent.start.x;
+
+    // Can't reach the goal (or is standing in a wall): hold position
+    if (map.isBlocked(agent.start.x, agent.start.y) || goalDistance[startTile] < 0) {
+        path.reset(width, 1);
+        path.set(0, startTile);
+        return false;
+    }
+
+    // a tile's ticks sit side by side, so a step and a wait touch nearby memory
+    const int ticks = window + 1;
+    context.begin(ticks, tileCount);
+    const int startState = startTile * ticks;
+    context.setNode(startState, 0, startState);
+
+    const float hStart = (float)goalDistance[startTile];
+    context.openList.push(startState, hStart, hStart);
+
+    int found = -1;
+
+    while (!context.openList.empty()) {
+        const int state = context.openList.pop();
+        context.close(state);
+
+        const int tile = state / ticks;
+        const int tick = state % ticks;
+
+        // The end of the window is as far as we look. The goal ends the
+        // search too, but only if nobody else needs it before then: the
+        // agent stays there for the rest of the window.
+        if (tick == window || (tile == goal && isFreeFrom(goal, tick + 1, agent.id))) {
+            found = state;
+            break;
+        }
+
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int m = 0; m < 5; m++) {
+            const int nx = x + MOVE_X[m];
+            const int ny = y + MOVE_Y[m];
+            if (map.isBlocked(nx, ny)) continue;
+
+            const int nextTile = ny * width + nx;
+            const int nextTick = tick + 1;
+
+            // someone else will be standing there
+            const int holder = reservations.reservedBy(nextTile, nextTick);
+            if (holder != -1 && holder != agent.id) continue;
+
+            // or is coming the other way through us
+            const int oncoming = reservations.reservedBy(nextTile, tick);
+            if (oncoming != -1 && oncoming != agent.id && reservations.reservedBy(tile, nextTick) == oncoming) continue;
+
+            const int next = nextTile * ticks + nextTick;
+            if (context.isClosed(next)) continue;
+
+            // every route to a state takes its tick in moves, so the
+            // first one found is as cheap as any
+            if (!context.isSeen(next)) {
+                const float hNew = (float)goalDistance[nextTile];
+
+                context.setNode(next, nextTick, state);
+                context.openList.push(next, nextTick + hNew, hNew);
+            }
+        }
+    }
+
+    if (found == -1) {
+        // boxed in for now; stay put and try again next round
+        path.reset(width, 1);
+        path.set(0, startTile);
+        return false;
+    }
+
+    // one tile per tick, so the state's tick is its slot in the path
+    path.reset(width, found % ticks + 1);
+
+    int state = found;
+    while (true) {
+        path.set(state % ticks, state / ticks);
+
+        const int parent = context.getParent(state);
+        if (parent == state) break;
+        state = parent;
+    }
+    return true;
+}
+
+bool CooperativePlanner::isFreeFrom(int tile, int tick, int agentId) const
+{
+    for (int t = tick; t <= window; t++) {
+        const int holder = reservations.reservedBy(tile, t);
+        if (holder != -1 && holder != agentId) return false;
+    }
+    return true;
+}
+
+void CooperativePlanner::reserve(const TilePath& path, int agentId)
+{
+    // A planned route only uses free (tile, tick)s, so a refused claim means
+    // a boxed-in agent left standing where an earlier one is going
+    for (int t = 0; t < path.size(); t++) {
+        if (!reservations.reserve(path.tileAt(t), t, agentId)) stats.conflicts++;
+    }
+
+    // stopped early (at the goal or boxed in): stay on the last tile
+    for (int t = path.size(); t <= window; t++) {
+        if (!reservations.reserve(path.backTile(), t, agentId)) stats.conflicts++;
+    }
+}
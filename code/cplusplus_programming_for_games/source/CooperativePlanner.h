@@ -0,0 +1,97 @@
+#pragma once
+
+#include <unordered_set>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Grid.h"
+#include "Map.h"
+#include "ReservationTable.h"
+#include "SearchContext.h"
+#include "TilePath.h"
+#include "Wavefront.h"
+
+// One agent in a cooperative planning round
+struct CoopAgent {
+    int id = 0;        // stable between rounds, used to remember deferrals
+    Node start;
+    int priority = 0;  // lower plans first
+};
+
+struct CoopResult {
+    // One tile per tick, starting with the agent's own tile. A tile repeated
+    // on consecutive ticks means wait there.
+    TilePath path;
+
+    // false if the round ran out of time before this agent's turn
+    bool planned = false;
+};
+
+// Windowed Hierarchical Cooperative A* (WHCA*) for agents chasing one goal.
+// Agents are planned one at a time in priority order. Each searches in
+// space-time, where waiting in place is a move, for the next `window` ticks.
+// It must avoid every (tile, tick) an earlier agent reserved, including two
+// agents swapping tiles, and only stops at the goal if it can stay there to
+// the window's end. It then reserves its own route. The heuristic is the
+// true distance to the goal, ignoring other agents, from a wavefront BFS
+// that is rebuilt only when the goal or the map changes.
+//
+// A round stops when it runs past its time budget. Agents not reached keep
+// their old paths, plan first next round, and the overrun shows up in
+// getStats().
+class CooperativePlanner {
+public:
+    struct Stats {
+        int rounds = 0;
+        int planned = 0;           // agents planned, all rounds
+        int deferred = 0;          // agents skipped for lack of time, all rounds
+        int overBudgetRounds = 0;  // rounds that hit the budget
+        long long expansions = 0;  // space-time states closed, all rounds
+        int conflicts = 0;         // ticks a boxed-in agent overlaps an earlier one, all rounds
+        float lastMs = 0.0f;
+        float worstMs = 0.0f;
+    };
+
+    explicit CooperativePlanner(int window = 16, float budgetMs = 2.0f);
+
+    // Plan count agents toward goal, writing results[i] for agents[i].
+    // Returns false if the budget ran out before every agent was planned.
+    bool plan(const Map& map, const CoopAgent* agents, CoopResult* results, int count, const Node& goal);
+
+    int getWindow() const { return window; }
+
+    void setBudgetMs(float ms) { budgetMs = ms; }
+    float getBudgetMs() const { return budgetMs; }
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = Stats(); }
+
+private:
+    // Space-time A* for one agent against the reservations so far
+    bool planAgent(const Map& map, const CoopAgent& agent, int goalTile, TilePath& path);
+
+    // Nobody but agentId holds tile from tick to the window's end
+    bool isFreeFrom(int tile, int tick, int agentId) const;
+
+    // Hold the agent's route in the table, then its last tile to the window's end
+    void reserve(const TilePath& path, int agentId);
+
+    int window;
+    float budgetMs;
+
+    ReservationTable reservations;
+
+    // states are tile * (window + 1) + tick
+    SearchContext context;
+
+    // steps to the goal from every tile, ignoring other agents
+    Wavefront wavefront;
+    Grid<int> goalDistance;
+    int goalTile = -1;
+    unsigned int mapVersion = 0;
+
+    std::vector<int> order;
+    std::unordered_set<int> deferredIds;
+
+    Stats stats;
+};
@@ -0,0 +1,235 @@
+#include "DStarLite.h"
+#include <algorithm>
+#include <cstdlib>
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+static const int INF = 1 << 28;
+
+int DStarLite::heuristic(int a, int b) const
+{
+    return std::abs(g.toX(a) - g.toX(b)) + std::abs(g.toY(a) - g.toY(b));
+}
+
+void DStarLite::calculateKey(int tile, float& k1, float& k2) const
+{
+    const int m = std::min(g[tile], rhs[tile]);
+    k1 = (float)(m + heuristic(tile, target) + km);
+    k2 = (float)m;
+}
+
+void DStarLite::initialise(const Map& map, int startTile, int targetTile)
+{
+    mapWidth = map.getWidth();
+    mapHeight = map.getHeight();
+    mapVersion = map.getVersion();
+
+    g.resize(mapWidth, mapHeight, INF);
+    rhs.resize(mapWidth, mapHeight, INF);
+    open.reset(g.size());
+
+    start = startTile;
+    target = targetTile;
+    km = 0;
+
+    rhs[start] = 0;
+
+    float k1, k2;
+    calculateKey(start, k1, k2);
+    open.push(start, k1, k2);
+
+    initialised = true;
+}
+
+void DStarLite::updateVertex(const Map& map, int tile)
+{
+    const int x = g.toX(tile);
+    const int y = g.toY(tile);
+
+    if (tile == start) {
+        rhs[tile] = 0;
+    }
+    else if (map.isBlocked(x, y)) {
+        rhs[tile] = INF;
+    }
+    else {
+        // best route in through any open neighbour
+        int best = INF;
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (map.isBlocked(nx, ny)) continue;
+
+            best = std::min(best, g.at(nx, ny) + 1);
+        }
+        rhs[tile] = std::min(best, INF);
+    }
+
+    if (g[tile] != rhs[tile]) {
+        float k1, k2;
+        calculateKey(tile, k1, k2);
+        open.update(tile, k1, k2);
+    }
+    else {
+        open.remove(tile);
+    }
+}
+
+void DStarLite::computeShortestPath(const Map& map)
+{
+    float targetK1, targetK2;
+    calculateKey(target, targetK1, targetK2);
+
+    while (!open.empty()) {
+        const bool topBelowTarget = open.topF() < targetK1 || (open.topF() == targetK1 && open.topH() < targetK2);
+        if (!topBelowTarget && rhs[target] == g[target]) break;
+
+        const int u = open.top();
+        const float oldK1 = open.topF();
+        const float oldK2 = open.topH();
+
+        float newK1, newK2;
+        calculateKey(u, newK1, newK2);
+
+        expansions++;
+
+        if (oldK1 < newK1 || (oldK1 == newK1 && oldK2 < newK2)) {
+            // key went stale after km grew
+            open.update(u, newK1, newK2);
+        }
+        else if (g[u] > rhs[u]) {
+            g[u] = rhs[u];
+            open.remove(u);
+
+            for (int d = 0; d < 4; d++) {
+                const int nx = g.toX(u) + DIR_X[d];
+                const int ny = g.toY(u) + DIR_Y[d];
+                if (g.inBounds(nx, ny)) updateVertex(map, g.index(nx, ny));
+            }
+        }
+        else {
+            g[u] = INF;
+            updateVertex(map, u);
+
+            for (int d = 0; d < 4; d++) {
+                const int nx = g.toX(u) + DIR_X[d];
+                const int ny = g.toY(u) + DIR_Y[d];
+                if (g.inBounds(nx, ny)) updateVertex(map, g.index(nx, ny));
+            }
+        }
+
+        calculateKey(target, targetK1, targetK2);
+    }
+}
+
+void DStarLite::moveRoot(const Map& map, int newStart)
+{
+    const int oldStart = start;
+    start = newStart;
+
+    // the old root now has to be reached like any other tile
+    updateVertex(map, oldStart);
+    updateVertex(map, newStart);
+}
+
+bool DStarLite::extractPath(const Map& map, std::vector<int>& tiles) const
+{
+    tiles.clear();
+
+    if (g[target] >= INF) return false;
+
+    int tile = target;
+    tiles.push_back(tile);
+
+    while (tile != start) {
+        const int x = g.toX(tile);
+        const int y = g.toY(tile);
+
+        int next = -1;
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (map.isBlocked(nx, ny)) continue;
+
+            if (g.at(nx, ny) + 1 == g[tile]) {
+                next = g.index(nx, ny);
+                break;
+            }
+        }
+
+        // tree is mid-repair; let the caller search again
+        if (next == -1) return false;
+
+        tile = next;
+        tiles.push_back(tile);
+    }
+
+    std::reverse(tiles.begin(), tiles.end());
+    return true;
+}
+
+std::vector<Node> DStarLite::plan(const Map& map, const Node& agent, const Node& goal)
+{
+    TilePath path;
+    plan(map, agent, goal, path);
+    return toNodes(path);
+}
+
+bool DStarLite::plan(const Map& map, const Node& agent, const Node& goal, TilePath& path)
+{
+    path.clear();
+    expansions = 0;
+
+    if (map.isBlocked(agent.x, agent.y) || map.isBlocked(goal.x, goal.y)) return false;
+    if (agent.x == goal.x && agent.y == goal.y) return false;
+    if (isUnreachable(map, agent, goal)) return false;
+
+    const int agentTile = agent.y * map.getWidth() + agent.x;
+    const int goalTile = goal.y * map.getWidth() + goal.x;
+
+    std::vector<int> changed;
+
+    if (!initialised || map.getWidth() != mapWidth || map.getHeight() != mapHeight
+        || !map.getChangesSince(mapVersion, changed)) {
+        initialise(map, agentTile, goalTile);
+    }
+    else {
+        // re-check the changed tiles and everything next to them
+        for (int tile : changed) {
+            updateVertex(map, tile);
+            for (int d = 0; d < 4; d++) {
+                const int nx = g.toX(tile) + DIR_X[d];
+                const int ny = g.toY(tile) + DIR_Y[d];
+                if (g.inBounds(nx, ny)) updateVertex(map, g.index(nx, ny));
+            }
+        }
+        mapVersion = map.getVersion();
+
+        if (goalTile != target) {
+            km += heuristic(target, goalTile);
+            target = goalTile;
+        }
+    }
+
+    computeShortestPath(map);
+
+    bool found = extractPath(map, route);
+
+    // The agent has walked off the start; keep going from where it is on the
+    // route if it is still on it, otherwise re-root the search there
+    std::vector<int>::iterator onPath = std::find(route.begin(), route.end(), agentTile);
+
+    if (agentTile != start && (!found || onPath == route.end())) {
+        moveRoot(map, agentTile);
+        computeShortestPath(map);
+        found = extractPath(map, route);
+        onPath = route.begin();
+    }
+
+    if (!found) return false;
+
+    path.assign(map.getWidth(), &*onPath, (int)(route.end() - onPath));
+    return true;
+}
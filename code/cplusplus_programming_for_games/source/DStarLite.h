@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Grid.h"
+#include "IndexedHeap.h"
+#include "Map.h"
+
+// Incremental planner for one chasing agent (D* Lite / LPA*, in the
+// moving-target form). The search tree is rooted at the tile the agent
+// planned from and is kept between calls:
+//  - the target moving only shifts the heuristic (km), and the repair stops
+//    as soon as the new target tile is consistent again
+//  - changed tiles (Map::getChangesSince) re-check just those tiles and their
+//    neighbours
+//  - the agent walking along the last path costs nothing; the tree is only
+//    re-rooted when the new route no longer passes through the agent
+class DStarLite {
+public:
+    // Path from agent to target in aStar() format, empty if unreachable
+    std::vector<Node> plan(const Map& map, const Node& agent, const Node& target);
+
+    // Same, written into a caller-owned path; false if unreachable
+    bool plan(const Map& map, const Node& agent, const Node& target, TilePath& path);
+
+    // Forget the search so the next plan() starts from scratch
+    void reset() { initialised = false; }
+
+    // Tiles expanded by the last plan() call
+    int getLastExpansions() const { return expansions; }
+
+private:
+    void initialise(const Map& map, int startTile, int targetTile);
+    void moveRoot(const Map& map, int newStart);
+
+    void calculateKey(int tile, float& k1, float& k2) const;
+    void updateVertex(const Map& map, int tile);
+    void computeShortestPath(const Map& map);
+
+    // Follow g downhill from the target back to the root. Returns false if
+    // the target is unreachable.
+    bool extractPath(const Map& map, std::vector<int>& tiles) const;
+
+    int heuristic(int a, int b) const;
+
+    Grid<int> g;
+    Grid<int> rhs;
+    IndexedHeap open;
+
+    int start = -1;
+    int target = -1;
+    int km = 0;
+    int expansions = 0;
+
+    // extracted route, kept so planning doesn't allocate
+    std::vector<int> route;
+
+    int mapWidth = 0;
+    int mapHeight = 0;
+    unsigned int mapVersion = 0;
+    bool initialised = false;
+};
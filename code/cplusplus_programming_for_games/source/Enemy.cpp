@@ -1,5 +1,7 @@
 #include "Enemy.h"
+#include "AnyAngleSearch.h"
 #include <cmath>
+#include <cstdlib>
 
 static bool aabbOverlap(const SDL_Rect& a, const SDL_Rect& b)
 {
@@ -44,8 +46,8 @@ bool Enemy::init(const char* texturePath, int spawnTileX_, int spawnTileY_)
 
     alive = true;
     animTime = 0.0f;
-    repathTimer = 0.0f;
     path.clear();
+    waypoints.clear();
     lastPlayerTileX = -999;
     lastPlayerTileY = -999;
 
@@ -71,18 +73,15 @@ void Enemy::resetToSpawn()
     ey = enemyTileY * TILE_SIZE + TILE_SIZE * 0.5f;
 
     path.clear();
-    repathTimer = 0.0f;
+    waypoints.clear();
+    planner.reset();
     lastPlayerTileX = -999;
     lastPlayerTileY = -999;
 }
 
 bool Enemy::isBlockedTile(int tx, int ty) const
 {
-    
-    if (tx < 0 || ty < 0 || tx >= 32 || ty >= 24) return true;
-
-    int t = (*map)[ty][tx];
-    return (t == 1 || t == 3);
+    return map->isBlocked(tx, ty);
 }
 
 SDL_Rect Enemy::getRect() const
@@ -116,63 +115,291 @@ void Enemy::recomputePath()
     if (!alive) return;
     if (!map || !player) return;
 
-    int pTileX = player->getCenterX() / TILE_SIZE;
-    int pTileY = player->getCenterY() / TILE_SIZE;
-
-    // clamp to map bounds
-    if (pTileX < 0) pTileX = 0;
-    if (pTileY < 0) pTileY = 0;
-    if (pTileX > 31) pTileX = 31;
-    if (pTileY > 23) pTileY = 23;
+    int pTileX, pTileY;
+    getPlayerTile(pTileX, pTileY);
 
     Node start{ enemyTileX, enemyTileY };
     Node dest{ pTileX, pTileY };
 
-    path = aStar(*map, start, dest);
+    waypoints.clear();
+    nextWaypoint = 0;
+
+    const int distance = std::abs(pTileX - enemyTileX) + std::abs(pTileY - enemyTileY);
+
+    if (chaseMode == ChaseMode::Incremental) {
+        planner.plan(*map, start, dest, path);
+    }
+    else if (hierarchy && searchMode == SearchMode::AStar
+        && distance > longPathDistance && hierarchy->findAbstractPath(*map, start, dest, waypoints)) {
+        // only the first leg is needed now, the rest waits until we get there
+        path.clear();
+        refineNextLeg();
+    }
+    else if (pathCache) {
+        pathCache->findPath(*map, start, dest, searchMode, path);
+    }
+    else {
+        findPath(*map, start, dest, searchMode, path);
+    }
+
+    // skip current tile if path returns it first
+    path.skipIfAt(enemyTileX, enemyTileY);
+    pathChanged();
+    repathCount++;
+
+    lastPlayerTileX = pTileX;
+    lastPlayerTileY = pTileY;
+}
+
+void Enemy::setChaseMode(ChaseMode mode)
+{
+    chaseMode = mode;
+
+    path.clear();
+    waypoints.clear();
+    planner.reset();
+
+    // forces a search on the next update
+    lastPlayerTileX = -999;
+    lastPlayerTileY = -999;
+}
+
+void Enemy::setSearchMode(SearchMode mode)
+{
+    if (mode == searchMode) return;
+
+    searchMode = mode;
+    lastPlayerTileX = -999;
+    lastPlayerTileY = -999;
+}
+
+void Enemy::getPlayerTile(int& tx, int& ty) const
+{
+    tx = player->getCenterX() / TILE_SIZE;
+    ty = player->getCenterY() / TILE_SIZE;
+
+    // clamp to map bounds
+    if (tx < 0) tx = 0;
+    if (ty < 0) ty = 0;
+    if (tx > map->getWidth() - 1) tx = map->getWidth() - 1;
+    if (ty > map->getHeight() - 1) ty = map->getHeight() - 1;
+}
+
+bool Enemy::repathDue()
+{
+    int pTileX, pTileY;
+    getPlayerTile(pTileX, pTileY);
+
+    if (map->getVersion() != pathVersion) {
+        dirty.clear();
+        const bool known = map->getDirtySince(pathVersion, dirty);
+        pathVersion = map->getVersion();
+
+        // no route last time, but a change might have opened one
+        const bool atGoal = enemyTileX == lastPlayerTileX && enemyTileY == lastPlayerTileY;
+        if (!known || (path.empty() && !atGoal)) return true;
+
+        for (const Map::DirtyRect& r : dirty) {
+            if (pathTiles.anyInRect(r.x, r.y, r.w, r.h, map->getWidth())) return true;
+            if (mayShortenPath(r)) return true;
+        }
+    }
+
+    if (pTileX == lastPlayerTileX && pTileY == lastPlayerTileY) return false;
+
+    return !followGoal(pTileX, pTileY);
+}
+
+// Manhattan distance from (x, y) to the nearest tile of r
+static int distanceToRect(const Map::DirtyRect& r, int x, int y)
+{
+    const int dx = x < r.x ? r.x - x : (x >= r.x + r.w ? x - (r.x + r.w - 1) : 0);
+    const int dy = y < r.y ? r.y - y : (y >= r.y + r.h ? y - (r.y + r.h - 1) : 0);
+    return dx + dy;
+}
+
+bool Enemy::mayShortenPath(const Map::DirtyRect& r) const
+{
+    // other modes' paths aren't shortest in steps, and a hierarchical leg
+    // doesn't end at the goal
+    const bool shortest = chaseMode == ChaseMode::Incremental || isShortestTileMode(searchMode);
+    if (!shortest || !waypoints.empty() || path.empty()) return false;
+
+    // Any route through the rectangle is at least this long
+    const int width = map->getWidth();
+    const int goal = path.backTile();
+    const int through = distanceToRect(r, enemyTileX, enemyTileY) + distanceToRect(r, goal % width, goal / width);
+    return through < path.size();
+}
+
+bool Enemy::followGoal(int pTileX, int pTileY)
+{
+    // D* Lite keeps its own path, and hierarchical legs don't end at the player
+    if (chaseMode == ChaseMode::Incremental || !waypoints.empty()) return false;
+
+    const int width = map->getWidth();
+    const int end = path.empty() ? enemyTileY * width + enemyTileX : path.backTile();
+    if (end != lastPlayerTileY * width + lastPlayerTileX) return false;
+
+    const int goal = pTileY * width + pTileX;
+
+    // Stepped back onto the path: what's left up to there is still shortest
+    bool onPath = goal == enemyTileY * width + enemyTileX;
+    int keep = 0;
+    while (!onPath && keep < path.size()) {
+        onPath = path.tileAt(keep++) == goal;
+    }
 
-    // remove current tile if path returns it first
-    if (!path.empty() && path.front().x == enemyTileX && path.front().y == enemyTileY) {
-        path.erase(path.begin());
+    if (onPath) {
+        path.truncate(keep);
+    }
+    else {
+        // One step past the end: walk on after them
+        if (std::abs(pTileX - lastPlayerTileX) + std::abs(pTileY - lastPlayerTileY) != 1) return false;
+        if (followSteps >= MAX_FOLLOW_STEPS) return false;
+
+        const bool passable = searchMode == SearchMode::Weighted
+            ? map->getMoveCost(pTileX, pTileY) > 0
+            : !map->isBlocked(pTileX, pTileY);
+        if (!passable) return false;
+
+        if (path.empty()) path.reset(width, 0);
+        path.append(goal);
+        pathTiles.set(goal);
+        followSteps++;
     }
 
+    followCount++;
     lastPlayerTileX = pTileX;
     lastPlayerTileY = pTileY;
+    return true;
+}
+
+void Enemy::pathChanged()
+{
+    pathTiles.assign(path, map->getWidth() * map->getHeight());
+
+    // an any-angle path also crosses the tiles between its turns
+    if (searchMode == SearchMode::AnyAngle) {
+        const int width = map->getWidth();
+        int x = enemyTileX;
+        int y = enemyTileY;
+
+        for (int i = 0; i < path.size(); i++) {
+            forEachTileOnLine(x, y, path.xAt(i), path.yAt(i), [&](int tx, int ty) {
+                pathTiles.set(ty * width + tx);
+                return true;
+            });
+            x = path.xAt(i);
+            y = path.yAt(i);
+        }
+    }
+
+    pathVersion = map->getVersion();
+    followSteps = 0;
+}
+
+bool Enemy::requestPath(PathQuery& query)
+{
+    if (!alive || chaseMode != ChaseMode::Batched) return false;
+    if (!map || !player) return false;
+    if (!repathDue()) return false;
+
+    int pTileX, pTileY;
+    getPlayerTile(pTileX, pTileY);
+
+    query.start = Node{ enemyTileX, enemyTileY };
+    query.dest = Node{ pTileX, pTileY };
+    query.mode = searchMode;
+
+    lastPlayerTileX = pTileX;
+    lastPlayerTileY = pTileY;
+    repathCount++;
+    return true;
+}
+
+void Enemy::applyPath(const TilePath& newPath, int skip)
+{
+    path.assignRemaining(newPath, skip);
+    waypoints.clear();
+    waitTimer = 0.0f;
+
+    // skip current tile if path returns it first
+    path.skipIfAt(enemyTileX, enemyTileY);
+    pathChanged();
+}
+
+void Enemy::refineNextLeg()
+{
+    // legs can be a single tile when a waypoint sits on the start
+    while (path.empty() && nextWaypoint + 1 < waypoints.size()) {
+        hierarchy->refineSegment(*map, waypoints[nextWaypoint], waypoints[nextWaypoint + 1], path);
+        nextWaypoint++;
+
+        path.skipIfAt(enemyTileX, enemyTileY);
+        pathTiles.assign(path, map->getWidth() * map->getHeight());
+    }
 }
 
 void Enemy::moveAlongPath(float dt)
 {
-    if (path.empty()) return;
+    int nextX = 0;
+    int nextY = 0;
+
+    const bool followField = chaseMode == ChaseMode::FlowField && flowField;
+
+    if (followField) {
+        if (!flowField->getNextStep(enemyTileX, enemyTileY, nextX, nextY)) return;
+    }
+    else {
+        if (path.empty() && hierarchy) refineNextLeg();
+        if (path.empty()) return;
 
-    const Node next = path.front();
-    const float targetX = next.x * TILE_SIZE + TILE_SIZE * 0.5f;
-    const float targetY = next.y * TILE_SIZE + TILE_SIZE * 0.5f;
+        nextX = path.frontX();
+        nextY = path.frontY();
+    }
+
+    const float targetX = nextX * TILE_SIZE + TILE_SIZE * 0.5f;
+    const float targetY = nextY * TILE_SIZE + TILE_SIZE * 0.5f;
 
     const float dx = targetX - ex;
     const float dy = targetY - ey;
     const float dist = std::sqrt(dx * dx + dy * dy);
 
-    if (dist < 0.5f) {
-        ex = targetX;
-        ey = targetY;
-        enemyTileX = next.x;
-        enemyTileY = next.y;
-        path.erase(path.begin());
+    // Weighted paths go through breakables: entering one takes its move cost
+    // in steps' worth of time, then it's smashed
+    const int cost = followField ? Map::FLOOR_COST : map->getMoveCost(nextX, nextY);
+    const float step = cost > Map::FLOOR_COST ? moveSpeed * dt / cost : moveSpeed * dt;
+
+    // Cooperative paths repeat a tile to wait on it for one step's time
+    if (!followField && dist < 0.5f && nextX == enemyTileX && nextY == enemyTileY) {
+        waitTimer += dt;
+        if (waitTimer < TILE_SIZE / moveSpeed) return;
+
+        waitTimer = 0.0f;
+        path.advance();
         return;
     }
 
-    const float step = moveSpeed * dt;
-
-    if (step >= dist) {
+    if (dist < 0.5f || step >= dist) {
         ex = targetX;
         ey = targetY;
-        enemyTileX = next.x;
-        enemyTileY = next.y;
-        path.erase(path.begin());
+        enemyTileX = nextX;
+        enemyTileY = nextY;
+        if (!followField) path.advance();
+        if (map->isBlocked(nextX, nextY)) map->breakTileAtPixel((int)targetX, (int)targetY);
         return;
     }
 
     ex += (dx / dist) * step;
     ey += (dy / dist) * step;
+
+    // Partway along a straight run to a tile further than a step away: a
+    // search from here should start where we are, not where the run began
+    if (std::abs(nextX - enemyTileX) > 1 || std::abs(nextY - enemyTileY) > 1) {
+        enemyTileX = (int)ex / TILE_SIZE;
+        enemyTileY = (int)ey / TILE_SIZE;
+    }
 }
 
 void Enemy::update(float dt)
@@ -181,19 +408,11 @@ void Enemy::update(float dt)
 
     if (!alive) return;
 
-    // Repath periodically or if player moved tiles
-    repathTimer += dt;
-
-    int pTileX = player->getCenterX() / TILE_SIZE;
-    int pTileY = player->getCenterY() / TILE_SIZE;
-
-    if (pTileX < 0) pTileX = 0;
-    if (pTileY < 0) pTileY = 0;
-    if (pTileX > 31) pTileX = 31;
-    if (pTileY > 23) pTileY = 23;
+    // Flow field, batched and cooperative paths are kept up to date by the game loop
+    const bool pathsFromLoop = chaseMode == ChaseMode::FlowField || chaseMode == ChaseMode::Batched
+        || chaseMode == ChaseMode::Cooperative;
 
-    if (repathTimer >= repathInterval || pTileX != lastPlayerTileX || pTileY != lastPlayerTileY) {
-        repathTimer = 0.0f;
+    if (!pathsFromLoop && repathDue()) {
         recomputePath();
     }
 
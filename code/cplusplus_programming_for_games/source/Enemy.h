@@ -7,6 +7,21 @@
 #include "Map.h"
 #include "Player.h"
 #include "AStarSearch.h"
+#include "DStarLite.h"
+#include "FlowField.h"
+#include "HierarchicalPathfinder.h"
+#include "PathBatch.h"
+#include "PathCache.h"
+#include "TileBits.h"
+
+// How an enemy works out its route to the player
+enum class ChaseMode {
+    FlowField,   // follow the shared field the game loop keeps
+    Incremental, // repair a private D* Lite search
+    Batched,     // the game loop searches for every enemy at once
+    PerEnemy,    // search alone: hierarchy for long chases, else cache / findPath
+    Cooperative  // the game loop plans every enemy together so they don't collide
+};
 
 class Enemy {
 public:
@@ -31,6 +46,37 @@ public:
     // Revive and return to spawn
     void resetToSpawn();
 
+    void setChaseMode(ChaseMode mode);
+
+    // Field followed in ChaseMode::FlowField
+    void setFlowField(const FlowField* field) { flowField = field; }
+
+    // ChaseMode::Batched: returns true and fills query when this enemy is
+    // due a new path. The game loop runs all the queries together and hands
+    // each answer back through applyPath() before calling update().
+    // A shared path is followed from skip tiles in.
+    bool requestPath(PathQuery& query);
+    void applyPath(const TilePath& newPath, int skip = 0);
+
+    // Tile the enemy last arrived on
+    int getTileX() const { return enemyTileX; }
+    int getTileY() const { return enemyTileY; }
+
+    // Search used for per-enemy paths; a change takes effect straight away
+    void setSearchMode(SearchMode mode);
+
+    // Share finished paths with other enemies and the player
+    void setPathCache(PathCache* cache) { pathCache = cache; }
+
+    // Route chases longer than longPathDistance tiles through the cluster
+    // graph, turning one leg into tiles at a time. Only with SearchMode::AStar;
+    // any other mode runs the search it names.
+    void setHierarchicalPathfinder(const HierarchicalPathfinder* hpa) { hierarchy = hpa; }
+
+    // Searches run, and player moves followed by reusing the path instead
+    int getRepathCount() const { return repathCount; }
+    int getFollowCount() const { return followCount; }
+
     int getCenterX() const { return (int)ex; }
     int getCenterY() const { return (int)ey; }
 
@@ -40,6 +86,29 @@ private:
     void recomputePath();
     void moveAlongPath(float dt);
 
+    // Player's tile, clamped to the map
+    void getPlayerTile(int& tx, int& ty) const;
+
+    // True if a changed tile lies on the path ahead or could make a shorter
+    // one, or the player moved in a way followGoal() can't absorb
+    bool repathDue();
+
+    // A change in r could open a route shorter than the path ahead. Only
+    // judged for D* Lite and isShortestTileMode() searches; other modes, and
+    // hierarchical legs, pick up new shortcuts at their next search.
+    bool mayShortenPath(const Map::DirtyRect& r) const;
+
+    // The player moved off the end of the path: trim the path if they
+    // stepped back onto it, or add their new tile if it's next to the end.
+    // False if neither applies and a search is needed.
+    bool followGoal(int pTileX, int pTileY);
+
+    // A new path was set: note its tiles and the map it was found on
+    void pathChanged();
+
+    // Fill path with the next leg of the hierarchical route, if any is left
+    void refineNextLeg();
+
     bool isBlockedTile(int tx, int ty) const;
 
 private:
@@ -74,9 +143,34 @@ private:
     float moveSpeed = 110.0f; // pixels/sec
 
     // pathing
-    std::vector<Node> path;
-    float repathTimer = 0.0f;
-    float repathInterval = 0.25f;
+    ChaseMode chaseMode = ChaseMode::PerEnemy;
+    const FlowField* flowField = nullptr;
+    TilePath path;
+    SearchMode searchMode = SearchMode::AStar;
+    PathCache* pathCache = nullptr;
+
+    DStarLite planner;
+
+    const HierarchicalPathfinder* hierarchy = nullptr;
+    std::vector<int> waypoints;
+    size_t nextWaypoint = 0;
+    int longPathDistance = 24;
+
+    // time spent on a wait step of a cooperative path
+    float waitTimer = 0.0f;
+
+    // tiles ahead on the path, checked against the map's dirty rectangles
+    TileBits pathTiles;
+    unsigned int pathVersion = 0;
+    std::vector<Map::DirtyRect> dirty;
+
+    // tiles added by followGoal() since the last search; each can leave the
+    // path up to 2 tiles longer than a fresh one, so this is capped
+    int followSteps = 0;
+    static const int MAX_FOLLOW_STEPS = 4;
+
+    int repathCount = 0;
+    int followCount = 0;
 
     int lastPlayerTileX = -999;
     int lastPlayerTileY = -999;
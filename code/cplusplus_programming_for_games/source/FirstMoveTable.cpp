@@ -0,0 +1,377 @@
+#include "FirstMoveTable.h"
+
+#include <algorithm>
+#include <chrono>
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+// Lowest direction in a mask of directions
+static int firstDirection(int mask)
+{
+    for (int d = 0; d < 4; d++) {
+        if (mask & (1 << d)) return d;
+    }
+    return -1;
+}
+
+// Breadth-first steps from source to every tile, -1 where unreachable
+static void distancesFrom(const WalkBits& walk, int source, std::vector<int>& dist, std::vector<int>& frontier)
+{
+    const int width = walk.getWidth();
+    const int height = walk.getHeight();
+
+    dist.assign(width * height, -1);
+    frontier.clear();
+
+    dist[source] = 0;
+    frontier.push_back(source);
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int tile = frontier[head];
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (!walk.get(nx, ny)) continue;
+
+            const int next = ny * width + nx;
+            if (dist[next] != -1) continue;
+
+            dist[next] = dist[tile] + 1;
+            frontier.push_back(next);
+        }
+    }
+}
+
+void FirstMoveTable::computeRow(const WalkBits& walk, int source, Row& row,
+    std::vector<int>& dist, std::vector<uint8_t>& moves, std::vector<int>& frontier)
+{
+    const int width = walk.getWidth();
+    const int height = walk.getHeight();
+    const int tileCount = width * height;
+
+    // Search from source, collecting for each tile every first move that
+    // starts a shortest path to it
+    dist.assign(tileCount, -1);
+    moves.assign(tileCount, 0);
+    frontier.clear();
+
+    dist[source] = 0;
+    frontier.push_back(source);
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int tile = frontier[head];
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (!walk.get(nx, ny)) continue;
+
+            const int next = ny * width + nx;
+            const uint8_t via = tile == source ? (uint8_t)(1 << d) : moves[tile];
+
+            if (dist[next] == -1) {
+                dist[next] = dist[tile] + 1;
+                moves[next] = via;
+                frontier.push_back(next);
+            }
+            else if (dist[next] == dist[tile] + 1) {
+                moves[next] |= via;
+            }
+        }
+    }
+
+    // Run-length encode, keeping a run going while some move suits every
+    // target in it. Unreachable targets (no moves) suit anything.
+    row.clear();
+
+    int runStart = 0;
+    int candidates = 0;
+
+    for (int t = 0; t < tileCount; t++) {
+        const int m = moves[t];
+        if (m == 0) continue;
+
+        if (candidates & m) {
+            candidates &= m;
+            continue;
+        }
+
+        if (candidates) {
+            row.push_back((uint32_t)runStart << 2 | firstDirection(candidates));
+            runStart = t;
+        }
+        candidates = m;
+    }
+
+    if (candidates) {
+        row.push_back((uint32_t)runStart << 2 | firstDirection(candidates));
+    }
+}
+
+FirstMoveTable::Rebuild FirstMoveTable::rebuildRows(const WalkBits& walk, const std::vector<int>& sources, unsigned int version)
+{
+    Rebuild r;
+    r.version = version;
+    r.sources = sources;
+    r.rows.resize(sources.size());
+
+    std::vector<int> dist;
+    std::vector<uint8_t> moves;
+    std::vector<int> frontier;
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        computeRow(walk, sources[i], r.rows[i], dist, moves, frontier);
+    }
+    return r;
+}
+
+void FirstMoveTable::build(const Map& map)
+{
+    // a rebuild still running would describe the old map
+    if (pending.valid()) pending.wait();
+    pending = std::future<Rebuild>();
+
+    walk = map.getWalkBits();
+    version = map.getVersion();
+    width = map.getWidth();
+    height = map.getHeight();
+
+    const int tileCount = width * height;
+
+    rows.clear();
+    staleSince.clear();
+    openedTiles.clear();
+    columns.clear();
+
+    if (tileCount > MAX_TILES) return;
+
+    rows.resize(tileCount);
+    staleSince.assign(tileCount, 0);
+
+    std::vector<int> dist;
+    std::vector<uint8_t> moves;
+    std::vector<int> frontier;
+
+    for (int s = 0; s < tileCount; s++) {
+        if (walk.get(s % width, s / width)) computeRow(walk, s, rows[s], dist, moves, frontier);
+    }
+}
+
+void FirstMoveTable::openTile(int tile, unsigned int newVersion)
+{
+    const int x = tile % width;
+    const int y = tile / width;
+    const int tileCount = width * height;
+
+    // Going through the new tile links its open neighbours two steps apart.
+    // A source is unaffected if it already reaches every neighbour within
+    // two steps of the nearest one; otherwise some path of its could now be
+    // shorter, so its row is rebuilt.
+    std::vector<int> nearest(tileCount, -1);
+    std::vector<int> farthest(tileCount, -1);
+    std::vector<bool> missed(tileCount, false);
+
+    std::vector<int> dist;
+    std::vector<int> frontier;
+
+    for (int d = 0; d < 4; d++) {
+        const int nx = x + DIR_X[d];
+        const int ny = y + DIR_Y[d];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+        if (!walk.get(nx, ny)) continue;
+
+        distancesFrom(walk, ny * width + nx, dist, frontier);
+        for (int s = 0; s < tileCount; s++) {
+            if (dist[s] == -1) {
+                missed[s] = true;
+                continue;
+            }
+            if (nearest[s] == -1 || dist[s] < nearest[s]) nearest[s] = dist[s];
+            if (dist[s] > farthest[s]) farthest[s] = dist[s];
+        }
+    }
+
+    for (int s = 0; s < tileCount; s++) {
+        if (nearest[s] == -1) continue;
+
+        if (missed[s] || farthest[s] > nearest[s] + 2) staleSince[s] = newVersion;
+    }
+
+    // the new tile's own row is needed too
+    staleSince[tile] = newVersion;
+    walk.set(x, y, true);
+
+    openedTiles.push_back(tile);
+}
+
+void FirstMoveTable::buildColumn(int target, std::vector<int8_t>& column)
+{
+    std::vector<int> dist;
+    std::vector<int> frontier;
+    distancesFrom(walk, target, dist, frontier);
+
+    const int tileCount = width * height;
+    column.assign(tileCount, -1);
+
+    for (int s = 0; s < tileCount; s++) {
+        if (dist[s] <= 0) continue;
+
+        const int x = s % width;
+        const int y = s / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+            if (dist[ny * width + nx] == dist[s] - 1) {
+                column[s] = (int8_t)d;
+                break;
+            }
+        }
+    }
+}
+
+void FirstMoveTable::update(const Map& map)
+{
+    if (rows.empty()) return;
+
+    if (pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        // a row made stale again by a later break waits for the next rebuild
+        Rebuild done = pending.get();
+        for (size_t i = 0; i < done.sources.size(); i++) {
+            const int s = done.sources[i];
+            if (staleSince[s] != 0 && staleSince[s] <= done.version) {
+                rows[s].swap(done.rows[i]);
+                staleSince[s] = 0;
+            }
+        }
+    }
+
+    if (map.getVersion() != version) {
+        std::vector<int> changed;
+        if (!map.getChangesSince(version, changed) || map.getWidth() != width || map.getHeight() != height) {
+            build(map);
+            return;
+        }
+
+        for (int tile : changed) {
+            const bool open = !map.isBlocked(tile % width, tile / width);
+            if (open == walk.get(tile % width, tile / width)) continue;
+
+            // a wall appearing can lengthen anything
+            if (!open) {
+                build(map);
+                return;
+            }
+            openTile(tile, map.getVersion());
+        }
+        version = map.getVersion();
+
+        // columns from before this change could be stale for the sources it touched
+        columns.resize(openedTiles.size());
+        for (size_t i = 0; i < openedTiles.size(); i++) {
+            buildColumn(openedTiles[i], columns[i]);
+        }
+    }
+
+    if (pending.valid()) return;
+
+    std::vector<int> sources;
+    for (int s = 0; s < (int)staleSince.size(); s++) {
+        if (staleSince[s] != 0) sources.push_back(s);
+    }
+    if (sources.empty()) return;
+
+    // the worker gets its own copy of the walkable bits, so the game can keep
+    // breaking tiles while it runs
+    WalkBits snapshot = walk;
+    const unsigned int snapshotVersion = version;
+
+    pending = std::async(std::launch::async, [snapshot, sources, snapshotVersion]() {
+        return rebuildRows(snapshot, sources, snapshotVersion);
+    });
+}
+
+int FirstMoveTable::firstMove(int source, int target) const
+{
+    for (size_t i = 0; i < openedTiles.size(); i++) {
+        if (openedTiles[i] == target) return columns[i][source];
+    }
+
+    if (staleSince[source] != 0) return -1;
+
+    const Row& row = rows[source];
+    if (row.empty()) return -1;
+
+    // last run starting at or before target
+    const uint32_t key = (uint32_t)target << 2 | 3;
+    Row::const_iterator it = std::upper_bound(row.begin(), row.end(), key);
+    return (int)(*(it - 1) & 3);
+}
+
+bool FirstMoveTable::tryFindPath(const Map& map, const Node& start, const Node& dest, TilePath& path) const
+{
+    path.clear();
+
+    if (rows.empty() || map.getVersion() != version) return false;
+
+    // same answers as the searches for these
+    if (map.isBlocked(dest.x, dest.y)) return true;
+    if (start.x == dest.x && start.y == dest.y) return true;
+    if (map.isBlocked(start.x, start.y)) return false;
+    if (isUnreachable(map, start, dest)) return true;
+
+    const int target = dest.y * width + dest.x;
+    int tile = start.y * width + start.x;
+
+    path.reset(width, 0);
+    path.append(tile);
+
+    // a path never visits a tile twice; this only guards against a bad row
+    for (int steps = 0; tile != target; steps++) {
+        const int d = firstMove(tile, target);
+        if (d < 0 || steps >= width * height) {
+            path.clear();
+            return false;
+        }
+
+        tile += DIR_Y[d] * width + DIR_X[d];
+        path.append(tile);
+    }
+    return true;
+}
+
+int FirstMoveTable::getStaleRowCount() const
+{
+    int count = 0;
+    for (unsigned int v : staleSince) {
+        if (v != 0) count++;
+    }
+    return count;
+}
+
+size_t FirstMoveTable::getMemoryBytes() const
+{
+    size_t bytes = 0;
+    for (const Row& row : rows) bytes += row.size() * sizeof(uint32_t);
+    for (const std::vector<int8_t>& column : columns) bytes += column.size();
+    return bytes;
+}
+
+bool firstMoveSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path)
+{
+    const FirstMoveTable* table = theMap.getFirstMoves();
+    if (table && table->tryFindPath(theMap, start, dest, path)) return !path.empty();
+
+    return aStar(theMap, start, dest, context, path);
+}
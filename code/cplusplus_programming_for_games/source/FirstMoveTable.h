@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Map.h"
+#include "WalkBits.h"
+
+// Compressed path database: for every source tile, the first step of a
+// shortest path to every target tile. A query follows first moves from the
+// start until it reaches the goal, so it costs O(path length) and no search.
+//
+// Each source's row is run-length encoded over target tile indices. Targets
+// that can't be reached are free to join either neighbouring run, and where
+// several first moves are equally short the one that extends the current
+// run is kept. The built-in level's 768 rows come to a few hundred runs each.
+//
+// Attach it with Map::setFirstMoves(); SearchMode::FirstMove then answers
+// from it. When a tile breaks, update() works out which sources could now
+// have a shorter path to anything and rebuilds just those rows on a
+// background thread. Queries passing through one of them fall back to
+// searching until it's in.
+class FirstMoveTable {
+public:
+    // All pairs grows with the square of the tile count; bigger maps get no table
+    static const int MAX_TILES = 4096;
+
+    // Build every row now, on this thread
+    void build(const Map& map);
+
+    // Call once a frame. Takes in tiles broken since the last call and
+    // installs or starts background row rebuilds.
+    void update(const Map& map);
+
+    // True if the table could answer: path is then the route, or empty if
+    // there is none. False if it's out of date for this query and the
+    // caller should search instead.
+    bool tryFindPath(const Map& map, const Node& start, const Node& dest, TilePath& path) const;
+
+    // Rows waiting for a background rebuild
+    int getStaleRowCount() const;
+
+    size_t getMemoryBytes() const;
+
+private:
+    // Runs of (first target << 2 | move), in target order. A run covers the
+    // targets up to the next run's first target; the first run starts at 0.
+    typedef std::vector<uint32_t> Row;
+
+    struct Rebuild {
+        unsigned int version = 0;
+        std::vector<int> sources;
+        std::vector<Row> rows;
+    };
+
+    static void computeRow(const WalkBits& walk, int source, Row& row,
+        std::vector<int>& dist, std::vector<uint8_t>& moves, std::vector<int>& frontier);
+
+    static Rebuild rebuildRows(const WalkBits& walk, const std::vector<int>& sources, unsigned int version);
+
+    // Direction of the first step from source toward target, -1 if unknown
+    int firstMove(int source, int target) const;
+
+    // Mark the rows a newly opened tile could shorten, then open it in walk
+    void openTile(int tile, unsigned int newVersion);
+
+    // First moves toward target from every tile, from one search on walk
+    void buildColumn(int target, std::vector<int8_t>& column);
+
+    WalkBits walk;
+    unsigned int version = 0;
+    int width = 0;
+    int height = 0;
+
+    std::vector<Row> rows;
+
+    // map version that made a row stale, 0 while it's current
+    std::vector<unsigned int> staleSince;
+
+    // Tiles opened since their rows and columns were built. A source whose
+    // distances didn't change keeps its row, so these columns give the first
+    // move toward a new tile from everywhere.
+    std::vector<int> openedTiles;
+    std::vector<std::vector<int8_t>> columns;
+
+    std::future<Rebuild> pending;
+};
+
+// Shortest path from the map's first-move table (Map::setFirstMoves), or
+// aStar() if it has none or it's out of date for this query
+bool firstMoveSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path);
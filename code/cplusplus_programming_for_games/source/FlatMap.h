@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map from 64-bit keys, laid out like ReservationTable
+// but with a fixed size: the slots are allocated once by the constructor and
+// insert() turns new keys away past half full rather than growing, so an
+// index built on it never allocates afterwards. clear() is O(1) by stamp.
+template <typename Value>
+class FlatMap {
+public:
+    // Room for at least maxCount keys
+    explicit FlatMap(size_t maxCount)
+    {
+        while (((size_t)1 << bits) < maxCount * 2) bits++;
+        slots.resize((size_t)1 << bits);
+    }
+
+    void clear()
+    {
+        generation++;
+        count = 0;
+
+        if (generation == 0) {
+            // wrapped around; old stamps could now look current
+            for (Slot& s : slots) s.stamp = 0;
+            generation = 1;
+        }
+    }
+
+    // Value stored under key, or nullptr
+    Value* find(uint64_t key)
+    {
+        for (size_t i = slotFor(key); slots[i].stamp == generation; i = next(i)) {
+            if (slots[i].key == key) return &slots[i].value;
+        }
+        return nullptr;
+    }
+
+    // Value stored under key, added as Value() if key is new. nullptr if
+    // it's new and the map is full.
+    Value* insert(uint64_t key)
+    {
+        size_t i = slotFor(key);
+        for (; slots[i].stamp == generation; i = next(i)) {
+            if (slots[i].key == key) return &slots[i].value;
+        }
+
+        if ((count + 1) * 2 > slots.size()) return nullptr;
+
+        count++;
+        slots[i].key = key;
+        slots[i].value = Value();
+        slots[i].stamp = generation;
+        return &slots[i].value;
+    }
+
+    void erase(uint64_t key)
+    {
+        size_t gap = slotFor(key);
+        for (;; gap = next(gap)) {
+            if (slots[gap].stamp != generation) return;
+            if (slots[gap].key == key) break;
+        }
+        count--;
+
+        // Move later keys of the run back into the gap wherever that's no
+        // earlier than their home slot, so no probe stops short at it
+        for (size_t j = next(gap); slots[j].stamp == generation; j = next(j)) {
+            const size_t mask = slots.size() - 1;
+            const size_t home = slotFor(slots[j].key);
+
+            if (((j - home) & mask) >= ((j - gap) & mask)) {
+                slots[gap] = slots[j];
+                gap = j;
+            }
+        }
+        slots[gap].stamp = 0;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        Value value = Value();
+        uint32_t stamp = 0;
+    };
+
+    // Fibonacci hashing: the top bits of the product pick the slot
+    size_t slotFor(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
+
+    size_t next(size_t i) const { return (i + 1) & (slots.size() - 1); }
+
+    std::vector<Slot> slots;
+    int bits = 4;
+    size_t count = 0;
+    uint32_t generation = 1;
+};
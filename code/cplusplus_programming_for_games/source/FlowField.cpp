@@ -0,0 +1,85 @@
+#include "FlowField.h"
+
+// up, right, down, left - same order aStar() checks neighbours in
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+const unsigned char FlowField::NO_STEP;
+
+bool FlowField::update(const Map& map, int newGoalX, int newGoalY)
+{
+    if (built && newGoalX == goalX && newGoalY == goalY && map.getVersion() == mapVersion) {
+        return false;
+    }
+
+    build(map, newGoalX, newGoalY);
+    return true;
+}
+
+void FlowField::build(const Map& map, int newGoalX, int newGoalY)
+{
+    goalX = newGoalX;
+    goalY = newGoalY;
+    mapVersion = map.getVersion();
+    built = true;
+
+    const int width = map.getWidth();
+    const int height = map.getHeight();
+
+    if (direction.getWidth() != width || direction.getHeight() != height) {
+        direction.resize(width, height, NO_STEP);
+        distance.resize(width, height, -1);
+    }
+    else {
+        direction.fill(NO_STEP);
+        distance.fill(-1);
+    }
+
+    if (map.isBlocked(goalX, goalY)) return;
+
+    // Breadth-first search outward from the goal. Each tile reached points
+    // back at the tile it was reached from, which is one step closer.
+    frontier.clear();
+    frontier.push_back(distance.index(goalX, goalY));
+    distance.at(goalX, goalY) = 0;
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int tile = frontier[head];
+        const int x = distance.toX(tile);
+        const int y = distance.toY(tile);
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+
+            if (map.isBlocked(nx, ny)) continue;
+            if (distance.at(nx, ny) != -1) continue;
+
+            distance.at(nx, ny) = distance[tile] + 1;
+
+            // stepping from the neighbour back toward this tile is the opposite direction
+            direction.at(nx, ny) = (unsigned char)((d + 2) % 4);
+
+            frontier.push_back(distance.index(nx, ny));
+        }
+    }
+}
+
+bool FlowField::getNextStep(int x, int y, int& nextX, int& nextY) const
+{
+    if (!direction.inBounds(x, y)) return false;
+
+    const unsigned char d = direction.at(x, y);
+    if (d == NO_STEP) return false;
+
+    nextX = x + DIR_X[d];
+    nextY = y + DIR_Y[d];
+    return true;
+}
+
+int FlowField::getDistance(int x, int y) const
+{
+    if (!distance.inBounds(x, y)) return -1;
+
+    return distance.at(x, y);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "Grid.h"
+#include "Map.h"
+
+// Shortest-path directions toward a single goal tile, shared by every agent
+// chasing that goal. One breadth-first search outward from the goal fills in,
+// for each reachable tile, which neighbour to step onto next.
+class FlowField {
+public:
+    // Rebuild if the goal tile moved or the map changed since the last build.
+    // Returns true if a rebuild happened.
+    bool update(const Map& map, int goalX, int goalY);
+
+    // Always rebuild toward goalX/goalY
+    void build(const Map& map, int goalX, int goalY);
+
+    // Next tile to move to from (x, y). False if (x, y) is the goal,
+    // unreachable, or off the field.
+    bool getNextStep(int x, int y, int& nextX, int& nextY) const;
+
+    // Steps from (x, y) to the goal, or -1 if unreachable
+    int getDistance(int x, int y) const;
+
+private:
+    static const unsigned char NO_STEP = 255;
+
+    Grid<unsigned char> direction;
+    Grid<int> distance;
+    std::vector<int> frontier;
+
+    int goalX = -1;
+    int goalY = -1;
+    unsigned int mapVersion = 0;
+    bool built = false;
+};
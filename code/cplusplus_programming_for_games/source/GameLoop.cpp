@@ -1,6 +1,7 @@
 #include "GameLoop.h"
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <SDL_mixer.h>
 
 GameLoop::GameLoop()
@@ -44,8 +45,12 @@ void GameLoop::init()
     map = new Map(this->renderer);
     map->init();
 
+    pathCache = new PathCache();
+
     player = new Player(this->renderer, map);
     player->init();
+    player->setPathCache(pathCache);
+    player->setSearchMode(searchMode);
 
     //inits all the enemies
     enemies.clear();
@@ -53,6 +58,40 @@ void GameLoop::init()
     enemies.reserve(maxEnemies);
     enemyRespawnTimers.reserve(maxEnemies);
 
+    flowField = new FlowField();
+    pathWorkers = new PathWorkerPool();
+    coopPlanner = new CooperativePlanner();
+
+    hierarchy = new HierarchicalPathfinder();
+    hierarchy->build(*map);
+
+    landmarks = new LandmarkHeuristic();
+    landmarks->build(*map);
+    map->setLandmarks(landmarks);
+
+    firstMoves = new FirstMoveTable();
+    firstMoves->build(*map);
+    map->setFirstMoves(firstMoves);
+
+    // quadratic to build, so kept on disk for next time
+    goalBounds = new GoalBounds();
+    const std::string boundsFile = GoalBounds::cacheFileName(*map);
+    if (!goalBounds->load(boundsFile, *map)) {
+        goalBounds->build(*map);
+        if (!goalBounds->save(boundsFile)) {
+            SDL_Log("Couldn't save goal bounds to %s", boundsFile.c_str());
+        }
+    }
+    map->setGoalBounds(goalBounds);
+
+    subgoals = new SubgoalGraph();
+    subgoals->build(*map);
+    map->setSubgoals(subgoals);
+
+    rectangles = new RectangleGraph();
+    rectangles->build(*map);
+    map->setRectangles(rectangles);
+
     // spawn tiles
     const int spawns[5][2] = {
         {30, 22},
@@ -62,9 +101,31 @@ void GameLoop::init()
         {25,  8}
     };
 
+    // one batched search from every spawn at once; an enemy walled off from
+    // the player would stand still all game
+    {
+        int spawnTiles[5];
+        for (int i = 0; i < 5; i++) spawnTiles[i] = spawns[i][1] * map->getWidth() + spawns[i][0];
+
+        MultiSourceBFS spawnReach;
+        spawnReach.run(*map, spawnTiles, 5);
+
+        const int playerTile = (player->getCenterY() / TILE_SIZE) * map->getWidth() + player->getCenterX() / TILE_SIZE;
+        for (int i = 0; i < 5; i++) {
+            if (spawnReach.distance(i, playerTile) < 0) {
+                SDL_Log("Spawn (%d, %d) can't reach the player", spawns[i][0], spawns[i][1]);
+            }
+        }
+    }
+
     for (int i = 0; i < maxEnemies; i++) {
         Enemy* e = new Enemy(this->renderer, map, player);
         e->init("assets/ENEMY.png", spawns[i][0], spawns[i][1]);
+        e->setFlowField(flowField);
+        e->setChaseMode(chaseMode);
+        e->setSearchMode(enemiesUseTerrain ? SearchMode::Weighted : searchMode);
+        e->setHierarchicalPathfinder(hierarchy);
+        e->setPathCache(pathCache);
         enemies.push_back(e);
         enemyRespawnTimers.push_back(0.0f);
     }
@@ -88,6 +149,39 @@ bool GameLoop::handleInput()
             return false;
         }
 
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_j) {
+            // first-move table -> A* -> jump point -> bidirectional -> specialized A*
+            // -> subgoal -> rectangles -> octile -> any-angle -> first-move table
+            if (searchMode == SearchMode::AStar) setSearchMode(SearchMode::JumpPoint);
+            else if (searchMode == SearchMode::JumpPoint) setSearchMode(SearchMode::Bidirectional);
+            else if (searchMode == SearchMode::Bidirectional) setSearchMode(SearchMode::Specialized);
+            else if (searchMode == SearchMode::Specialized) setSearchMode(SearchMode::Subgoal);
+            else if (searchMode == SearchMode::Subgoal) setSearchMode(SearchMode::Rectangles);
+            else if (searchMode == SearchMode::Rectangles) setSearchMode(SearchMode::Octile);
+            else if (searchMode == SearchMode::Octile) setSearchMode(SearchMode::AnyAngle);
+            else if (searchMode == SearchMode::AnyAngle) setSearchMode(SearchMode::FirstMove);
+            else setSearchMode(SearchMode::AStar);
+        }
+
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_t) {
+            enemiesUseTerrain = !enemiesUseTerrain;
+            setSearchMode(searchMode);
+        }
+
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_c) {
+            switch (chaseMode) {
+            case ChaseMode::FlowField:   setChaseMode(ChaseMode::Incremental); break;
+            case ChaseMode::Incremental: setChaseMode(ChaseMode::Batched); break;
+            case ChaseMode::Batched:     setChaseMode(ChaseMode::PerEnemy); break;
+            case ChaseMode::PerEnemy:    setChaseMode(ChaseMode::Cooperative); break;
+            default:                     setChaseMode(ChaseMode::FlowField); break;
+            }
+        }
+
+        if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F1) {
+            showPathStats = !showPathStats;
+        }
+
         if (e.type == SDL_MOUSEBUTTONDOWN) {
             int mx, my;
             SDL_GetMouseState(&mx, &my);
@@ -141,8 +235,29 @@ void GameLoop::update()
     if (dt > 0.05f) dt = 0.05f;
 
     map->update();
+    hierarchy->update(*map);
+    landmarks->update(*map);
+    firstMoves->update(*map);
+    goalBounds->update(*map);
+    subgoals->update(*map);
+    rectangles->update(*map);
     player->update(dt);
 
+    // Rebuild the shared field only when the player changes tile or a tile breaks
+    if (chaseMode == ChaseMode::FlowField) {
+        int pTileX = player->getCenterX() / TILE_SIZE;
+        int pTileY = player->getCenterY() / TILE_SIZE;
+        flowField->update(*map, pTileX, pTileY);
+    }
+
+    if (chaseMode == ChaseMode::Batched) {
+        updateEnemyPaths();
+    }
+
+    if (chaseMode == ChaseMode::Cooperative) {
+        updateCooperativePaths(dt);
+    }
+
     // update enemies and handle respawn
     for (int i = 0; i < (int)enemies.size(); i++) {
         Enemy* e = enemies[i];
@@ -170,8 +285,8 @@ void GameLoop::update()
     camY = py - (windowH * 0.5f) / zoom;
 
     // Clamp camera to map bounds
-    float mapW = 32.0f * TILE_SIZE;
-    float mapH = 24.0f * TILE_SIZE;
+    float mapW = (float)map->getWidth() * TILE_SIZE;
+    float mapH = (float)map->getHeight() * TILE_SIZE;
 
     float maxX = mapW - (windowW / zoom);
     float maxY = mapH - (windowH / zoom);
@@ -261,6 +376,90 @@ void GameLoop::update()
     }
 }
 
+void GameLoop::updateEnemyPaths()
+{
+    pathBroker.clear();
+    pathRequesters.clear();
+
+    // request handles are 0, 1, 2... in submit order
+    for (auto* e : enemies) {
+        PathQuery query;
+        if (e && e->requestPath(query)) {
+            pathBroker.submit(*map, query);
+            pathRequesters.push_back(e);
+        }
+    }
+
+    if (pathRequesters.empty()) return;
+
+    pathBroker.run(*map, *pathWorkers);
+
+    for (int i = 0; i < (int)pathRequesters.size(); i++) {
+        pathRequesters[i]->applyPath(pathBroker.getPath(i), pathBroker.getOffset(i));
+    }
+}
+
+void GameLoop::updateCooperativePaths(float dt)
+{
+    // Plan a round on a timer, or straight away when the player changes tile
+    const int pTileX = player->getCenterX() / TILE_SIZE;
+    const int pTileY = player->getCenterY() / TILE_SIZE;
+    const int pTile = pTileY * map->getWidth() + pTileX;
+
+    coopTimer += dt;
+    if (coopTimer < coopInterval && pTile == coopPlayerTile) return;
+
+    coopTimer = 0.0f;
+    coopPlayerTile = pTile;
+
+    coopAgents.clear();
+    coopEnemies.clear();
+
+    for (int i = 0; i < (int)enemies.size(); i++) {
+        Enemy* e = enemies[i];
+        if (!e || !e->isAlive()) continue;
+
+        // nearest the player plans first, so the chase front gets the best routes
+        CoopAgent agent;
+        agent.id = i;
+        agent.start = Node{ e->getTileX(), e->getTileY() };
+        agent.priority = std::abs(e->getTileX() - pTileX) + std::abs(e->getTileY() - pTileY);
+
+        coopAgents.push_back(agent);
+        coopEnemies.push_back(e);
+    }
+
+    if (coopAgents.empty()) return;
+
+    if (coopResults.size() < coopAgents.size()) {
+        coopResults.resize(coopAgents.size());
+    }
+
+    const Node goal{ pTileX, pTileY };
+    const bool finished = coopPlanner->plan(*map, coopAgents.data(), coopResults.data(), (int)coopAgents.size(), goal);
+
+    // report once each time planning starts running over
+    if (!finished && !coopOverBudget) {
+        SDL_Log("Cooperative planning over budget: %.2f ms for %d enemies (budget %.2f ms)",
+            coopPlanner->getStats().lastMs, (int)coopAgents.size(), coopPlanner->getBudgetMs());
+    }
+    coopOverBudget = !finished;
+
+    for (size_t i = 0; i < coopEnemies.size(); i++) {
+        if (coopResults[i].planned) coopEnemies[i]->applyPath(coopResults[i].path);
+    }
+}
+
+void GameLoop::setChaseMode(ChaseMode mode)
+{
+    chaseMode = mode;
+    coopPlayerTile = -1;
+
+    for (auto* e : enemies) {
+        if (e) e->setChaseMode(mode);
+    }
+}
+
 void GameLoop::draw()
 {
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
@@ -294,11 +493,65 @@ void GameLoop::draw()
     if (font) {
         std::string scoreText = "SCORE=" + std::to_string(score);
         font->renderTopRight(scoreText, windowW, 10);
+
+        if (showPathStats) drawPathStats();
     }
 
     SDL_RenderPresent(renderer);
 }
 
+void GameLoop::drawPathStats()
+{
+    const PathCache::Stats& stats = pathCache->getStats();
+
+    std::string cacheText = "CACHE HIT=" + std::to_string((int)(stats.hitRate() * 100.0f)) + "%"
+        + " SIZE=" + std::to_string(pathCache->size()) + "/" + std::to_string(pathCache->getCapacity())
+        + " EVICT=" + std::to_string(stats.evictions);
+    font->renderAt(cacheText, 10, 50);
+
+    // enemies search only when the map changes under their path or the
+    // player moves somewhere the old path can't be stretched to
+    if (chaseMode != ChaseMode::FlowField && chaseMode != ChaseMode::Cooperative) {
+        int repaths = 0;
+        int follows = 0;
+        for (auto* e : enemies) {
+            if (!e) continue;
+            repaths += e->getRepathCount();
+            follows += e->getFollowCount();
+        }
+        std::string repathText = "REPATHS=" + std::to_string(repaths) + " FOLLOWED=" + std::to_string(follows);
+        font->renderAt(repathText, 10, 110);
+    }
+
+    if (chaseMode == ChaseMode::Batched) {
+        const PathBroker::Stats& broker = pathBroker.getStats();
+        std::string brokerText = "BROKER REQ=" + std::to_string(broker.requests)
+            + " SEARCHED=" + std::to_string(broker.searches)
+            + " COALESCED=" + std::to_string(broker.coalesced());
+        font->renderAt(brokerText, 10, 80);
+    }
+
+    if (chaseMode == ChaseMode::Cooperative) {
+        const CooperativePlanner::Stats& coop = coopPlanner->getStats();
+        std::string coopText = "COOP LAST=" + std::to_string((int)(coop.lastMs * 1000.0f)) + "us"
+            + " WORST=" + std::to_string((int)(coop.worstMs * 1000.0f)) + "us"
+            + " OVER=" + std::to_string(coop.overBudgetRounds)
+            + " DEFERRED=" + std::to_string(coop.deferred)
+            + " CONFLICTS=" + std::to_string(coop.conflicts);
+        font->renderAt(coopText, 10, 80);
+    }
+}
+
+void GameLoop::setSearchMode(SearchMode mode)
+{
+    searchMode = mode;
+
+    if (player) player->setSearchMode(mode);
+    for (auto* e : enemies) {
+        if (e) e->setSearchMode(enemiesUseTerrain ? SearchMode::Weighted : mode);
+    }
+}
+
 bool GameLoop::initAudio()
 {
     if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
@@ -376,10 +629,30 @@ void GameLoop::clean()
     delete player;
     delete map;
     delete font;
+    delete flowField;
+    delete pathWorkers;
+    delete coopPlanner;
+    delete hierarchy;
+    delete landmarks;
+    delete firstMoves;
+    delete goalBounds;
+    delete subgoals;
+    delete rectangles;
+    delete pathCache;
 
     player = nullptr;
     map = nullptr;
     font = nullptr;
+    flowField = nullptr;
+    pathWorkers = nullptr;
+    coopPlanner = nullptr;
+    hierarchy = nullptr;
+    landmarks = nullptr;
+    firstMoves = nullptr;
+    goalBounds = nullptr;
+    subgoals = nullptr;
+    rectangles = nullptr;
+    pathCache = nullptr;
 
     if (bgm) {
         Mix_HaltMusic();
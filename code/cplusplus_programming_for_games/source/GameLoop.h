@@ -7,9 +7,21 @@
 #include <string>
 #include <SDL_mixer.h>
 
+#include "CooperativePlanner.h"
 #include "Map.h"
 #include "Player.h"
 #include "Enemy.h"
+#include "FlowField.h"
+#include "HierarchicalPathfinder.h"
+#include "FirstMoveTable.h"
+#include "GoalBounds.h"
+#include "LandmarkHeuristic.h"
+#include "MultiSourceBFS.h"
+#include "PathBatch.h"
+#include "PathBroker.h"
+#include "PathCache.h"
+#include "RectangleGraph.h"
+#include "SubgoalGraph.h"
 #include "FontRenderer.h"
 
 struct Bullet {
@@ -41,6 +53,64 @@ private:
     int maxEnemies = 5;
     float enemyRespawnDelay = 3.0f;
 
+    // how enemies find the player; see ChaseMode. C cycles it
+    ChaseMode chaseMode = ChaseMode::FlowField;
+    void setChaseMode(ChaseMode mode);
+
+    // one search toward the player shared by every enemy
+    FlowField* flowField = nullptr;
+
+    // ChaseMode::Batched: every due enemy is searched for in one go, with
+    // requests that can share a path coalesced by the broker
+    PathWorkerPool* pathWorkers = nullptr;
+    PathBroker pathBroker;
+    std::vector<Enemy*> pathRequesters;
+    void updateEnemyPaths();
+
+    // ChaseMode::Cooperative: all enemies planned together every round
+    CooperativePlanner* coopPlanner = nullptr;
+    std::vector<CoopAgent> coopAgents;
+    std::vector<CoopResult> coopResults;
+    std::vector<Enemy*> coopEnemies;
+    float coopTimer = 0.0f;
+    float coopInterval = 0.25f;
+    int coopPlayerTile = -1;
+    bool coopOverBudget = false;
+    void updateCooperativePaths(float dt);
+
+    // cluster graph for long enemy chases, kept in step with broken tiles
+    HierarchicalPathfinder* hierarchy = nullptr;
+
+    // ALT distance tables for aStar(), rebuilt in the background after breaks
+    LandmarkHeuristic* landmarks = nullptr;
+
+    // first move between every pair of tiles, so most paths need no search
+    FirstMoveTable* firstMoves = nullptr;
+
+    // per-move boxes that keep aStar() on the route, saved per map
+    GoalBounds* goalBounds = nullptr;
+
+    // convex corners and the straight-ahead links between them
+    SubgoalGraph* subgoals = nullptr;
+
+    // open areas cut into rectangles the search only walks the edges of
+    RectangleGraph* rectangles = nullptr;
+
+    // finished paths shared by the player and enemies
+    PathCache* pathCache = nullptr;
+
+    // F1 shows pathfinding counters under the score
+    bool showPathStats = false;
+    void drawPathStats();
+
+    // search used for player clicks and per-enemy paths, J cycles it
+    SearchMode searchMode = SearchMode::FirstMove;
+    void setSearchMode(SearchMode mode);
+
+    // T: enemies path by terrain cost instead (SearchMode::Weighted),
+    // smashing through breakables when that's quicker than going round
+    bool enemiesUseTerrain = false;
+
     // UI
     FontRenderer* font = nullptr;
     int score = 0;
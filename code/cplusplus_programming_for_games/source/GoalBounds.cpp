@@ -0,0 +1,407 @@
+#include "GoalBounds.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <thread>
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+// Saved file layout: this header, then every Box in tile order
+struct GoalBoundsHeader {
+    char magic[4];
+    uint32_t format;
+    int32_t width;
+    int32_t height;
+    uint64_t hash;
+};
+
+static const char GOAL_BOUNDS_MAGIC[4] = { 'G', 'B', 'N', 'D' };
+static const uint32_t GOAL_BOUNDS_FORMAT = 1;
+
+// Breadth-first steps from source to every tile, -1 where unreachable
+static void distancesFrom(const WalkBits& walk, int source, std::vector<int>& dist, std::vector<int>& frontier)
+{
+    const int width = walk.getWidth();
+    const int height = walk.getHeight();
+
+    dist.assign(width * height, -1);
+    frontier.clear();
+
+    dist[source] = 0;
+    frontier.push_back(source);
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int tile = frontier[head];
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (!walk.get(nx, ny)) continue;
+
+            const int next = ny * width + nx;
+            if (dist[next] != -1) continue;
+
+            dist[next] = dist[tile] + 1;
+            frontier.push_back(next);
+        }
+    }
+}
+
+// FNV-1a over the size and one byte per tile
+static uint64_t hashWalk(const WalkBits& walk)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    };
+
+    mix((uint32_t)walk.getWidth());
+    mix((uint32_t)walk.getHeight());
+
+    for (int y = 0; y < walk.getHeight(); y++) {
+        for (int x = 0; x < walk.getWidth(); x++) {
+            hash ^= walk.get(x, y) ? 1 : 0;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+uint64_t GoalBounds::hashMap(const Map& map)
+{
+    return hashWalk(map.getWalkBits());
+}
+
+std::string GoalBounds::cacheFileName(const Map& map)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "goalbounds_%016llx.bin", (unsigned long long)hashMap(map));
+    return name;
+}
+
+void GoalBounds::computeTile(const WalkBits& walk, int source, Box* out,
+    std::vector<int>& dist, std::vector<uint8_t>& moves, std::vector<int>& frontier)
+{
+    const int width = walk.getWidth();
+    const int height = walk.getHeight();
+    const int tileCount = width * height;
+
+    // Search from source, collecting for each tile every first move that
+    // starts a shortest path to it
+    dist.assign(tileCount, -1);
+    moves.assign(tileCount, 0);
+    frontier.clear();
+
+    dist[source] = 0;
+    frontier.push_back(source);
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int tile = frontier[head];
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (!walk.get(nx, ny)) continue;
+
+            const int next = ny * width + nx;
+            const uint8_t via = tile == source ? (uint8_t)(1 << d) : moves[tile];
+
+            if (dist[next] == -1) {
+                dist[next] = dist[tile] + 1;
+                moves[next] = via;
+                frontier.push_back(next);
+            }
+            else if (dist[next] == dist[tile] + 1) {
+                moves[next] |= via;
+            }
+        }
+    }
+
+    for (int d = 0; d < 4; d++) out[d] = Box{ INT16_MAX, INT16_MAX, -1, -1 };
+
+    // the search's list holds just the tiles it reached
+    for (size_t i = 1; i < frontier.size(); i++) {
+        const int t = frontier[i];
+        const int16_t x = (int16_t)(t % width);
+        const int16_t y = (int16_t)(t / width);
+
+        for (int d = 0; d < 4; d++) {
+            if (!(moves[t] & (1 << d))) continue;
+
+            if (x < out[d].minX) out[d].minX = x;
+            if (y < out[d].minY) out[d].minY = y;
+            if (x > out[d].maxX) out[d].maxX = x;
+            if (y > out[d].maxY) out[d].maxY = y;
+        }
+    }
+}
+
+GoalBounds::Rebuild GoalBounds::computeTiles(const WalkBits& walk, const std::vector<int>& sources, unsigned int version)
+{
+    Rebuild r;
+    r.version = version;
+    r.sources = sources;
+    r.boxes.resize(sources.size() * 4);
+
+    unsigned int threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+    if (threadCount > sources.size()) threadCount = (unsigned int)sources.size();
+
+    // threads take the next source until none are left; each writes only
+    // its own sources' boxes
+    std::atomic<size_t> next(0);
+    Box* out = r.boxes.data();
+
+    const auto work = [&walk, &sources, &next, out]() {
+        std::vector<int> dist;
+        std::vector<uint8_t> moves;
+        std::vector<int> frontier;
+
+        for (size_t i = next++; i < sources.size(); i = next++) {
+            computeTile(walk, sources[i], out + i * 4, dist, moves, frontier);
+        }
+    };
+
+    // the calling thread is one of them
+    std::vector<std::future<void>> helpers;
+    for (unsigned int i = 1; i < threadCount; i++) {
+        helpers.push_back(std::async(std::launch::async, work));
+    }
+    work();
+
+    for (std::future<void>& h : helpers) h.wait();
+    return r;
+}
+
+void GoalBounds::build(const Map& map)
+{
+    // a rebuild still running would describe the old map
+    if (pending.valid()) pending.wait();
+    pending = std::future<Rebuild>();
+
+    walk = map.getWalkBits();
+    version = map.getVersion();
+    width = map.getWidth();
+    height = map.getHeight();
+
+    const int tileCount = width * height;
+
+    boxes.clear();
+    staleSince.clear();
+    if (tileCount > MAX_TILES) return;
+
+    // A blocked tile can still be a search's start (standing in a new
+    // wall), so it lets every move through
+    boxes.assign((size_t)tileCount * 4, Box{ 0, 0, (int16_t)(width - 1), (int16_t)(height - 1) });
+    staleSince.assign(tileCount, 0);
+
+    std::vector<int> sources;
+    for (int s = 0; s < tileCount; s++) {
+        if (walk.get(s % width, s / width)) sources.push_back(s);
+    }
+
+    const Rebuild r = computeTiles(walk, sources, version);
+    for (size_t i = 0; i < sources.size(); i++) {
+        std::copy(&r.boxes[i * 4], &r.boxes[i * 4] + 4, &boxes[(size_t)sources[i] * 4]);
+    }
+}
+
+void GoalBounds::openTile(int tile, unsigned int newVersion)
+{
+    const int x = tile % width;
+    const int y = tile / width;
+    const int tileCount = width * height;
+
+    // Going through the new tile links its open neighbours two steps apart.
+    // A source that already reaches them all at the same distance gains no
+    // shorter or equally short path through it; any other could, so its
+    // boxes are rebuilt.
+    std::vector<int> nearest(tileCount, -1);
+    std::vector<int> farthest(tileCount, -1);
+    std::vector<bool> missed(tileCount, false);
+
+    std::vector<int> dist;
+    std::vector<int> frontier;
+
+    for (int d = 0; d < 4; d++) {
+        const int nx = x + DIR_X[d];
+        const int ny = y + DIR_Y[d];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+        if (!walk.get(nx, ny)) continue;
+
+        distancesFrom(walk, ny * width + nx, dist, frontier);
+        for (int s = 0; s < tileCount; s++) {
+            if (dist[s] == -1) {
+                missed[s] = true;
+                continue;
+            }
+            if (nearest[s] == -1 || dist[s] < nearest[s]) nearest[s] = dist[s];
+            if (dist[s] > farthest[s]) farthest[s] = dist[s];
+        }
+    }
+
+    // A rebuild already under way for a source was searched without the new
+    // tile either, so that source waits for a later one
+    for (int s = 0; s < tileCount; s++) {
+        if (nearest[s] == -1) continue;
+
+        if (missed[s] || farthest[s] > nearest[s] || staleSince[s] != 0) staleSince[s] = newVersion;
+    }
+    staleSince[tile] = newVersion;
+
+    walk.set(x, y, true);
+
+    // The sources left alone still need the new tile as a target: it goes
+    // in the box of each move that starts a shortest path to it
+    distancesFrom(walk, tile, dist, frontier);
+
+    for (size_t i = 1; i < frontier.size(); i++) {
+        const int s = frontier[i];
+        if (staleSince[s] != 0) continue;
+
+        const int sx = s % width;
+        const int sy = s / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = sx + DIR_X[d];
+            const int ny = sy + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (dist[ny * width + nx] != dist[s] - 1) continue;
+
+            Box& b = boxes[(size_t)s * 4 + d];
+            if (x < b.minX) b.minX = (int16_t)x;
+            if (y < b.minY) b.minY = (int16_t)y;
+            if (x > b.maxX) b.maxX = (int16_t)x;
+            if (y > b.maxY) b.maxY = (int16_t)y;
+        }
+    }
+}
+
+void GoalBounds::update(const Map& map)
+{
+    if (boxes.empty()) return;
+
+    if (pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        // a tile made stale again by a later break waits for the next rebuild
+        Rebuild done = pending.get();
+        for (size_t i = 0; i < done.sources.size(); i++) {
+            const int s = done.sources[i];
+            if (staleSince[s] != 0 && staleSince[s] <= done.version) {
+                std::copy(&done.boxes[i * 4], &done.boxes[i * 4] + 4, &boxes[(size_t)s * 4]);
+                staleSince[s] = 0;
+            }
+        }
+    }
+
+    if (map.getVersion() != version) {
+        std::vector<int> changed;
+        if (!map.getChangesSince(version, changed) || map.getWidth() != width || map.getHeight() != height) {
+            build(map);
+            return;
+        }
+
+        for (int tile : changed) {
+            const bool open = !map.isBlocked(tile % width, tile / width);
+            if (open == walk.get(tile % width, tile / width)) continue;
+
+            // a wall appearing can lengthen anything
+            if (!open) {
+                build(map);
+                return;
+            }
+            openTile(tile, map.getVersion());
+        }
+        version = map.getVersion();
+    }
+
+    if (pending.valid()) return;
+
+    std::vector<int> sources;
+    for (int s = 0; s < (int)staleSince.size(); s++) {
+        if (staleSince[s] != 0) sources.push_back(s);
+    }
+    if (sources.empty()) return;
+
+    // the worker gets its own copy of the walkable bits, so the game can keep
+    // breaking tiles while it runs
+    WalkBits snapshot = walk;
+    const unsigned int snapshotVersion = version;
+
+    pending = std::async(std::launch::async, [snapshot, sources, snapshotVersion]() {
+        return computeTiles(snapshot, sources, snapshotVersion);
+    });
+}
+
+int GoalBounds::getStaleTileCount() const
+{
+    int count = 0;
+    for (unsigned int v : staleSince) {
+        if (v != 0) count++;
+    }
+    return count;
+}
+
+bool GoalBounds::save(const std::string& path) const
+{
+    if (boxes.empty() || getStaleTileCount() != 0) return false;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    GoalBoundsHeader header;
+    std::copy(GOAL_BOUNDS_MAGIC, GOAL_BOUNDS_MAGIC + 4, header.magic);
+    header.format = GOAL_BOUNDS_FORMAT;
+    header.width = width;
+    header.height = height;
+
+    // walk is the map the boxes were made for
+    header.hash = hashWalk(walk);
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)boxes.data(), boxes.size() * sizeof(Box));
+    return (bool)file;
+}
+
+bool GoalBounds::load(const std::string& path, const Map& map)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    GoalBoundsHeader header;
+    if (!file.read((char*)&header, sizeof(header))) return false;
+
+    if (!std::equal(GOAL_BOUNDS_MAGIC, GOAL_BOUNDS_MAGIC + 4, header.magic)) return false;
+    if (header.format != GOAL_BOUNDS_FORMAT) return false;
+    if (header.width != map.getWidth() || header.height != map.getHeight()) return false;
+    if (header.hash != hashMap(map)) return false;
+
+    std::vector<Box> loaded((size_t)header.width * header.height * 4);
+    if (!file.read((char*)loaded.data(), loaded.size() * sizeof(Box))) return false;
+
+    // a build could be running for whatever was here before
+    if (pending.valid()) pending.wait();
+    pending = std::future<Rebuild>();
+
+    boxes.swap(loaded);
+    staleSince.assign((size_t)header.width * header.height, 0);
+    walk = map.getWalkBits();
+    version = map.getVersion();
+    width = map.getWidth();
+    height = map.getHeight();
+    return true;
+}
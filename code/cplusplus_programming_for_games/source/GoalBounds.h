@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "Map.h"
+#include "WalkBits.h"
+
+// Goal bounding: for every tile and each of its four moves, the bounding box
+// of all the tiles a shortest path from there can start with that move.
+// aStar() skips a neighbour whose box doesn't hold the destination; no
+// shortest path to it goes that way, so the search stays optimal and mostly
+// expands just the tiles along the route.
+//
+// The build runs a search from every tile, split across threads. It is
+// quadratic in the tile count, so it's saved to a file named after a hash of
+// the walkable tiles and loaded from there when the same map comes round.
+//
+// Attach it with Map::setGoalBounds(). After a tile breaks, update() works
+// out which tiles could now have a shorter path to somewhere and rebuilds
+// only their boxes, on a background thread; every other tile's boxes just
+// take in the new tile. Tiles waiting for new boxes prune nothing.
+class GoalBounds {
+public:
+    // Bigger maps get no boxes
+    static const int MAX_TILES = 16384;
+
+    // Build every box now, on all cores
+    void build(const Map& map);
+
+    // Call once a frame. Takes in tiles broken since the last call and
+    // installs or starts background box rebuilds.
+    void update(const Map& map);
+
+    // Boxes describe the map as it is now
+    bool isCurrent(const Map& map) const
+    {
+        return !boxes.empty() && version == map.getVersion();
+    }
+
+    // False if no shortest path from tile to (destX, destY) starts with
+    // move dir (up, right, down, left)
+    bool mayLeadTo(int tile, int dir, int destX, int destY) const
+    {
+        if (staleSince[tile] != 0) return true;
+
+        const Box& b = boxes[(size_t)tile * 4 + dir];
+        return destX >= b.minX && destX <= b.maxX && destY >= b.minY && destY <= b.maxY;
+    }
+
+    // Hash of the map's size and walkable tiles, which is all the boxes
+    // depend on
+    static uint64_t hashMap(const Map& map);
+
+    // File name the boxes for this map are saved under
+    static std::string cacheFileName(const Map& map);
+
+    // Write the boxes to path; false if the file couldn't be written or
+    // some boxes are still being rebuilt
+    bool save(const std::string& path) const;
+
+    // Read boxes saved for this map; false (and nothing changed) if the file
+    // is missing, damaged or was saved for a different map
+    bool load(const std::string& path, const Map& map);
+
+    // Tiles waiting for a background rebuild
+    int getStaleTileCount() const;
+
+    size_t getMemoryBytes() const { return boxes.size() * sizeof(Box); }
+
+private:
+    // Inclusive tile bounds; empty while minX > maxX
+    struct Box {
+        int16_t minX;
+        int16_t minY;
+        int16_t maxX;
+        int16_t maxY;
+    };
+
+    struct Rebuild {
+        unsigned int version = 0;
+        std::vector<int> sources;
+
+        // four per source
+        std::vector<Box> boxes;
+    };
+
+    // Boxes of one source tile from a search of walk
+    static void computeTile(const WalkBits& walk, int source, Box* out,
+        std::vector<int>& dist, std::vector<uint8_t>& moves, std::vector<int>& frontier);
+
+    // Boxes of every tile in sources, spread over all cores
+    static Rebuild computeTiles(const WalkBits& walk, const std::vector<int>& sources, unsigned int version);
+
+    // Mark the tiles a newly opened tile could give shorter or extra
+    // shortest paths, add the tile to everyone else's boxes, then open it
+    // in walk
+    void openTile(int tile, unsigned int newVersion);
+
+    WalkBits walk;
+    unsigned int version = 0;
+    int width = 0;
+    int height = 0;
+
+    // [tile * 4 + move]
+    std::vector<Box> boxes;
+
+    // map version that made a tile's boxes stale, 0 while they're current
+    std::vector<unsigned int> staleSince;
+
+    std::future<Rebuild> pending;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// 2D array with its size chosen at runtime.
+// Cells are stored contiguously row by row, row y starting at y * stride.
+// A tile index (index()) is that flat offset, so code that walks the grid
+// with a single int can convert back with toX() / toY().
+template <typename T>
+class Grid {
+public:
+    Grid() {}
+
+    Grid(int width, int height, const T& fill = T())
+    {
+        resize(width, height, fill);
+    }
+
+    // Resize and fill every cell; existing contents are discarded
+    void resize(int newWidth, int newHeight, const T& fill = T())
+    {
+        width = newWidth;
+        height = newHeight;
+        stride = newWidth;
+        cells.assign((size_t)stride * height, fill);
+    }
+
+    void fill(const T& value)
+    {
+        cells.assign(cells.size(), value);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getStride() const { return stride; }
+
+    // Number of tile indices, including any padding at row ends
+    int size() const { return (int)cells.size(); }
+
+    bool inBounds(int x, int y) const
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    int index(int x, int y) const { return y * stride + x; }
+    int toX(int i) const { return i % stride; }
+    int toY(int i) const { return i / stride; }
+
+    T& at(int x, int y) { return cells[index(x, y)]; }
+    const T& at(int x, int y) const { return cells[index(x, y)]; }
+
+    T& operator[](int i) { return cells[i]; }
+    const T& operator[](int i) const { return cells[i]; }
+
+    T* row(int y) { return cells.data() + (size_t)y * stride; }
+    const T* row(int y) const { return cells.data() + (size_t)y * stride; }
+
+private:
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    std::vector<T> cells;
+};
@@ -0,0 +1,441 @@
+#include "HierarchicalPathfinder.h"
+#include <algorithm>
+#include <cstdlib>
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+// Scratch for queries, one per thread, so once it has grown a query and
+// its legs allocate nothing. The abstract search's nodes are tiles, so it
+// runs on a map-sized SearchContext.
+static thread_local SearchContext abstractContext;
+static thread_local std::vector<int> startDist;
+static thread_local std::vector<int> goalDist;
+static thread_local std::vector<int> legDist;
+static thread_local std::vector<int> legParent;
+static thread_local std::vector<int> crossings;
+static thread_local std::vector<int> frontier;
+
+// Border runs at least this long get an entrance at each end instead of one in the middle
+static const int WIDE_ENTRANCE = 6;
+
+static Node makeNode(int x, int y, int parentX, int parentY, float g)
+{
+    Node n;
+    n.x = x;
+    n.y = y;
+    n.parentX = parentX;
+    n.parentY = parentY;
+    n.gCost = g;
+    n.hCost = 0.0f;
+    n.fCost = g;
+    return n;
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(int clusterSize_)
+    : clusterSize(clusterSize_)
+{
+}
+
+int HierarchicalPathfinder::clusterAt(int x, int y) const
+{
+    return (y / clusterSize) * clustersX + (x / clusterSize);
+}
+
+int HierarchicalPathfinder::localIndex(const Cluster& c, int tile) const
+{
+    const int x = tile % mapWidth;
+    const int y = tile / mapWidth;
+    return (y - c.y0) * (c.x1 - c.x0) + (x - c.x0);
+}
+
+void HierarchicalPathfinder::build(const Map& map)
+{
+    mapWidth = map.getWidth();
+    mapHeight = map.getHeight();
+    clustersX = (mapWidth + clusterSize - 1) / clusterSize;
+    clustersY = (mapHeight + clusterSize - 1) / clusterSize;
+
+    const int count = clustersX * clustersY;
+    clusters.assign(count, Cluster());
+    eastBorders.assign(count, std::vector<Transition>());
+    southBorders.assign(count, std::vector<Transition>());
+
+    for (int cy = 0; cy < clustersY; cy++) {
+        for (int cx = 0; cx < clustersX; cx++) {
+            Cluster& c = clusters[cy * clustersX + cx];
+            c.x0 = cx * clusterSize;
+            c.y0 = cy * clusterSize;
+            c.x1 = std::min(c.x0 + clusterSize, mapWidth);
+            c.y1 = std::min(c.y0 + clusterSize, mapHeight);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        buildBorder(map, i, true);
+        buildBorder(map, i, false);
+    }
+
+    for (int i = 0; i < count; i++) {
+        buildCluster(map, i);
+    }
+
+    mapVersion = map.getVersion();
+    built = true;
+}
+
+void HierarchicalPathfinder::update(const Map& map)
+{
+    if (!built || map.getWidth() != mapWidth || map.getHeight() != mapHeight) {
+        build(map);
+        return;
+    }
+
+    if (map.getVersion() == mapVersion) return;
+
+    std::vector<int> changed;
+    if (!map.getChangesSince(mapVersion, changed)) {
+        build(map);
+        return;
+    }
+
+    std::vector<char> dirty(clusters.size(), 0);
+
+    for (int tile : changed) {
+        const int cx = (tile % mapWidth) / clusterSize;
+        const int cy = (tile / mapWidth) / clusterSize;
+        const int c = cy * clustersX + cx;
+
+        dirty[c] = 1;
+
+        // A border only concerns the cluster on its other side if its entrances moved
+        if (buildBorder(map, c, true)) dirty[c + 1] = 1;
+        if (buildBorder(map, c, false)) dirty[c + clustersX] = 1;
+        if (cx > 0 && buildBorder(map, c - 1, true)) dirty[c - 1] = 1;
+        if (cy > 0 && buildBorder(map, c - clustersX, false)) dirty[c - clustersX] = 1;
+    }
+
+    for (size_t i = 0; i < clusters.size(); i++) {
+        if (dirty[i]) buildCluster(map, (int)i);
+    }
+
+    mapVersion = map.getVersion();
+}
+
+bool HierarchicalPathfinder::buildBorder(const Map& map, int cluster, bool east)
+{
+    const Cluster& c = clusters[cluster];
+    const int cx = cluster % clustersX;
+    const int cy = cluster / clustersX;
+
+    std::vector<Transition> transitions;
+
+    // no neighbour on that side
+    if ((east && cx + 1 >= clustersX) || (!east && cy + 1 >= clustersY)) {
+        return false;
+    }
+
+    // walk along the border; (ax, ay) is in this cluster and (bx, by) across it
+    const int length = east ? (c.y1 - c.y0) : (c.x1 - c.x0);
+    int runStart = -1;
+
+    for (int i = 0; i <= length; i++) {
+        bool open = false;
+
+        if (i < length) {
+            const int ax = east ? c.x1 - 1 : c.x0 + i;
+            const int ay = east ? c.y0 + i : c.y1 - 1;
+            const int bx = east ? c.x1 : ax;
+            const int by = east ? ay : c.y1;
+            open = !map.isBlocked(ax, ay) && !map.isBlocked(bx, by);
+        }
+
+        if (open && runStart == -1) {
+            runStart = i;
+        }
+        else if (!open && runStart != -1) {
+            const int runEnd = i - 1;
+            int picks[2] = { runStart + (runEnd - runStart + 1) / 2, -1 };
+
+            if (runEnd - runStart + 1 >= WIDE_ENTRANCE) {
+                picks[0] = runStart;
+                picks[1] = runEnd;
+            }
+
+            for (int p : picks) {
+                if (p == -1) continue;
+
+                const int ax = east ? c.x1 - 1 : c.x0 + p;
+                const int ay = east ? c.y0 + p : c.y1 - 1;
+                const int bx = east ? c.x1 : ax;
+                const int by = east ? ay : c.y1;
+                transitions.push_back({ ay * mapWidth + ax, by * mapWidth + bx });
+            }
+            runStart = -1;
+        }
+    }
+
+    std::vector<Transition>& border = east ? eastBorders[cluster] : southBorders[cluster];
+    if (border == transitions) return false;
+
+    border.swap(transitions);
+    return true;
+}
+
+void HierarchicalPathfinder::buildCluster(const Map& map, int cluster)
+{
+    Cluster& c = clusters[cluster];
+    const int cx = cluster % clustersX;
+    const int cy = cluster / clustersX;
+
+    c.nodes.clear();
+    for (const Transition& t : eastBorders[cluster]) c.nodes.push_back(t.from);
+    for (const Transition& t : southBorders[cluster]) c.nodes.push_back(t.from);
+    if (cx > 0) {
+        for (const Transition& t : eastBorders[cluster - 1]) c.nodes.push_back(t.to);
+    }
+    if (cy > 0) {
+        for (const Transition& t : southBorders[cluster - clustersX]) c.nodes.push_back(t.to);
+    }
+
+    std::sort(c.nodes.begin(), c.nodes.end());
+    c.nodes.erase(std::unique(c.nodes.begin(), c.nodes.end()), c.nodes.end());
+
+    const size_t n = c.nodes.size();
+    c.distances.assign(n * n, -1);
+
+    std::vector<int> dist;
+    for (size_t i = 0; i < n; i++) {
+        searchCluster(map, c, c.nodes[i], dist, nullptr);
+        for (size_t j = 0; j < n; j++) {
+            c.distances[i * n + j] = dist[localIndex(c, c.nodes[j])];
+        }
+    }
+}
+
+void HierarchicalPathfinder::searchCluster(const Map& map, const Cluster& c, int tile, std::vector<int>& dist, std::vector<int>* parent) const
+{
+    const int w = c.x1 - c.x0;
+    const int h = c.y1 - c.y0;
+
+    dist.assign(w * h, -1);
+    if (parent) parent->assign(w * h, -1);
+
+    frontier.clear();
+    frontier.push_back(localIndex(c, tile));
+    dist[frontier[0]] = 0;
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int local = frontier[head];
+        const int x = c.x0 + local % w;
+        const int y = c.y0 + local / w;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+
+            if (nx < c.x0 || ny < c.y0 || nx >= c.x1 || ny >= c.y1) continue;
+            if (map.isBlocked(nx, ny)) continue;
+
+            const int next = (ny - c.y0) * w + (nx - c.x0);
+            if (dist[next] != -1) continue;
+
+            dist[next] = dist[local] + 1;
+            if (parent) (*parent)[next] = local;
+            frontier.push_back(next);
+        }
+    }
+}
+
+void HierarchicalPathfinder::getCrossings(int cluster, int tile, std::vector<int>& out) const
+{
+    const int cx = cluster % clustersX;
+    const int cy = cluster / clustersX;
+
+    for (const Transition& t : eastBorders[cluster]) {
+        if (t.from == tile) out.push_back(t.to);
+    }
+    for (const Transition& t : southBorders[cluster]) {
+        if (t.from == tile) out.push_back(t.to);
+    }
+    if (cx > 0) {
+        for (const Transition& t : eastBorders[cluster - 1]) {
+            if (t.to == tile) out.push_back(t.from);
+        }
+    }
+    if (cy > 0) {
+        for (const Transition& t : southBorders[cluster - clustersX]) {
+            if (t.to == tile) out.push_back(t.from);
+        }
+    }
+}
+
+bool HierarchicalPathfinder::findAbstractPath(const Map& map, const Node& start, const Node& dest, std::vector<int>& waypoints) const
+{
+    waypoints.clear();
+
+    if (!built) return false;
+    if (isUnreachable(map, start, dest)) return false;
+    if (map.isBlocked(start.x, start.y) || map.isBlocked(dest.x, dest.y)) return false;
+
+    const int startTile = start.y * mapWidth + start.x;
+    const int goalTile = dest.y * mapWidth + dest.x;
+    const int startCluster = clusterAt(start.x, start.y);
+    const int goalCluster = clusterAt(dest.x, dest.y);
+    const Cluster& sc = clusters[startCluster];
+    const Cluster& gc = clusters[goalCluster];
+
+    // connect the start and goal to the entrances of their clusters
+    searchCluster(map, sc, startTile, startDist, nullptr);
+    searchCluster(map, gc, goalTile, goalDist, nullptr);
+
+    // The start and goal are nodes like the entrances, keyed on their tile.
+    // One that sits on an entrance just is that entrance, with extra links.
+    SearchContext& context = abstractContext;
+    context.begin(mapWidth, mapHeight);
+
+    auto heuristic = [&](int tile) {
+        return (float)(std::abs(tile % mapWidth - dest.x) + std::abs(tile / mapWidth - dest.y));
+    };
+
+    // in-cluster distances are never below Manhattan, so the heuristic is
+    // consistent and closed nodes are final
+    auto relax = [&](int from, int to, int cost) {
+        if (context.isClosed(to)) return;
+
+        const int32_t g = context.getG(from) + cost;
+        if (context.isSeen(to) && context.getG(to) <= g) return;
+
+        const float h = heuristic(to);
+        context.setNode(to, g, from);
+        context.openList.push(to, g + h, h);
+    };
+
+    context.setNode(startTile, 0, startTile);
+    context.openList.push(startTile, heuristic(startTile), heuristic(startTile));
+
+    bool found = false;
+
+    while (!context.openList.empty()) {
+        const int tile = context.openList.pop();
+        context.close(tile);
+
+        if (tile == goalTile) {
+            found = true;
+            break;
+        }
+
+        if (tile == startTile) {
+            for (int node : sc.nodes) {
+                const int d = startDist[localIndex(sc, node)];
+                if (d >= 0) relax(tile, node, d);
+            }
+        }
+
+        const int cluster = clusterAt(tile % mapWidth, tile / mapWidth);
+        const Cluster& c = clusters[cluster];
+        const size_t n = c.nodes.size();
+        const size_t i = std::lower_bound(c.nodes.begin(), c.nodes.end(), tile) - c.nodes.begin();
+
+        if (i < n && c.nodes[i] == tile) {
+            for (size_t j = 0; j < n; j++) {
+                const int d = c.distances[i * n + j];
+                if (j != i && d >= 0) relax(tile, c.nodes[j], d);
+            }
+        }
+
+        crossings.clear();
+        getCrossings(cluster, tile, crossings);
+        for (int next : crossings) relax(tile, next, 1);
+
+        if (cluster == goalCluster && goalDist[localIndex(gc, tile)] >= 0) {
+            relax(tile, goalTile, goalDist[localIndex(gc, tile)]);
+        }
+    }
+
+    if (!found) return false;
+
+    for (int tile = goalTile; tile != startTile; tile = context.getParent(tile)) {
+        waypoints.push_back(tile);
+    }
+    waypoints.push_back(startTile);
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    return true;
+}
+
+std::vector<Node> HierarchicalPathfinder::refineSegment(const Map& map, int fromTile, int toTile) const
+{
+    TilePath path;
+    refineSegment(map, fromTile, toTile, path);
+    return toNodes(path);
+}
+
+bool HierarchicalPathfinder::refineSegment(const Map& map, int fromTile, int toTile, TilePath& path) const
+{
+    const int fx = fromTile % mapWidth;
+    const int fy = fromTile / mapWidth;
+    const int tx = toTile % mapWidth;
+    const int ty = toTile / mapWidth;
+
+    if (fromTile == toTile) {
+        path.reset(mapWidth, 1);
+        path.set(0, fromTile);
+        return true;
+    }
+
+    // one step across a cluster border
+    if (std::abs(fx - tx) + std::abs(fy - ty) == 1) {
+        path.reset(mapWidth, 2);
+        path.set(0, fromTile);
+        path.set(1, toTile);
+        return true;
+    }
+
+    const int cluster = clusterAt(fx, fy);
+    if (cluster == clusterAt(tx, ty)) {
+        const Cluster& c = clusters[cluster];
+
+        // search back from the target so following parents runs forward
+        searchCluster(map, c, toTile, legDist, &legParent);
+
+        int local = localIndex(c, fromTile);
+        if (legDist[local] > 0) {
+            const int w = c.x1 - c.x0;
+            path.reset(mapWidth, legDist[local] + 1);
+
+            for (int i = 0; local != -1; i++) {
+                path.set(i, (c.y0 + local / w) * mapWidth + c.x0 + local % w);
+                local = legParent[local];
+            }
+            return true;
+        }
+    }
+
+    // the map changed under the route; search the whole level instead
+    Node from = makeNode(fx, fy, fx, fy, 0.0f);
+    Node to = makeNode(tx, ty, tx, ty, 0.0f);
+    return aStar(map, from, to, abstractContext, path);
+}
+
+std::vector<Node> HierarchicalPathfinder::findPath(const Map& map, const Node& start, const Node& dest) const
+{
+    std::vector<Node> usablePath;
+
+    if (start.x == dest.x && start.y == dest.y) return usablePath;
+
+    std::vector<int> waypoints;
+    if (!findAbstractPath(map, start, dest, waypoints)) return usablePath;
+
+    for (size_t i = 0; i + 1 < waypoints.size(); i++) {
+        std::vector<Node> segment = refineSegment(map, waypoints[i], waypoints[i + 1]);
+        if (segment.empty()) return std::vector<Node>();
+
+        // each leg starts where the previous one ended
+        size_t first = usablePath.empty() ? 0 : 1;
+        usablePath.insert(usablePath.end(), segment.begin() + first, segment.end());
+    }
+
+    return usablePath;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Map.h"
+
+// HPA*: the map is cut into square clusters. Wherever two neighbouring
+// clusters share open border tiles there is an entrance, and the distances
+// between the entrances of each cluster are computed up front. A query
+// searches that small abstract graph, and each leg of the route is turned
+// into tiles only when it is needed (refineSegment()).
+//
+// Breaking a tile rebuilds its own cluster, plus a neighbour only if
+// the entrances on their shared border moved.
+class HierarchicalPathfinder {
+public:
+    explicit HierarchicalPathfinder(int clusterSize = 8);
+
+    // Full rebuild for the current map
+    void build(const Map& map);
+
+    // Catch up with tiles changed since the last build or update
+    void update(const Map& map);
+
+    // Coarse route as tile indices: the start, the entrances to pass through
+    // and dest. Consecutive waypoints are in the same cluster or are
+    // neighbouring tiles across a cluster border. False straight away if
+    // dest is in another region, before any cluster is searched.
+    bool findAbstractPath(const Map& map, const Node& start, const Node& dest, std::vector<int>& waypoints) const;
+
+    // Tile-by-tile path between two consecutive waypoints, both ends included
+    std::vector<Node> refineSegment(const Map& map, int fromTile, int toTile) const;
+
+    // As above, written into a caller-owned path; false (and an empty path)
+    // if the map has changed so the two are no longer connected
+    bool refineSegment(const Map& map, int fromTile, int toTile, TilePath& path) const;
+
+    // Abstract route with every leg refined, in the same format as aStar()
+    std::vector<Node> findPath(const Map& map, const Node& start, const Node& dest) const;
+
+private:
+    struct Cluster {
+        // tile bounds, [x0, x1) x [y0, y1)
+        int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+        // entrance tiles inside this cluster
+        std::vector<int> nodes;
+
+        // nodes.size() x nodes.size() steps between entrances, -1 if the
+        // cluster has no route between them
+        std::vector<int> distances;
+    };
+
+    // One crossing between neighbouring clusters: from is in the west/north
+    // cluster, to is the adjacent tile in the east/south one
+    struct Transition {
+        int from;
+        int to;
+
+        bool operator==(const Transition& other) const { return from == other.from && to == other.to; }
+    };
+
+    int clusterAt(int x, int y) const;
+
+    // Rebuild the entrances on a cluster's east or south border.
+    // Returns true if they changed.
+    bool buildBorder(const Map& map, int cluster, bool east);
+
+    void buildCluster(const Map& map, int cluster);
+
+    // Breadth-first search from tile inside one cluster. dist and parent are
+    // indexed by the tile's position within the cluster.
+    void searchCluster(const Map& map, const Cluster& c, int tile, std::vector<int>& dist, std::vector<int>* parent) const;
+
+    int localIndex(const Cluster& c, int tile) const;
+
+    // Tiles on other clusters' borders reachable in one step from tile
+    void getCrossings(int cluster, int tile, std::vector<int>& out) const;
+
+    int clusterSize;
+    int clustersX = 0;
+    int clustersY = 0;
+    int mapWidth = 0;
+    int mapHeight = 0;
+    unsigned int mapVersion = 0;
+    bool built = false;
+
+    std::vector<Cluster> clusters;
+    std::vector<std::vector<Transition>> eastBorders;
+    std::vector<std::vector<Transition>> southBorders;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <vector>
+
+// Binary min-heap of tile indices ordered by f-cost, ties broken on h-cost.
+// Each tile is in the heap at most once; position[] tracks where it lives so
+// a cheaper route found later can be applied with decreaseKey().
+class IndexedHeap {
+public:
+    // Prepare for a grid of tileCount tiles and empty the heap.
+    // Only tiles still queued need clearing, so this is cheap between searches.
+    void reset(int tileCount)
+    {
+        if ((int)position.size() != tileCount) {
+            position.assign(tileCount, -1);
+        }
+        else {
+            for (const Entry& e : heap) position[e.tile] = -1;
+        }
+        heap.clear();
+    }
+
+    bool empty() const { return heap.empty(); }
+    int size() const { return (int)heap.size(); }
+
+    bool contains(int tile) const { return position[tile] != -1; }
+
+    // Insert a tile, or lower its key if it is already queued
+    void push(int tile, float f, float h)
+    {
+        if (contains(tile)) {
+            decreaseKey(tile, f, h);
+            return;
+        }
+
+        heap.push_back({ tile, f, h });
+        position[tile] = (int)heap.size() - 1;
+        siftUp((int)heap.size() - 1);
+    }
+
+    void decreaseKey(int tile, float f, float h)
+    {
+        int i = position[tile];
+        Entry& e = heap[i];
+
+        if (!less(f, h, e.f, e.h)) return;
+
+        e.f = f;
+        e.h = h;
+        siftUp(i);
+    }
+
+    // Change a queued tile's key in either direction, or insert it
+    void update(int tile, float f, float h)
+    {
+        if (!contains(tile)) {
+            push(tile, f, h);
+            return;
+        }
+
+        int i = position[tile];
+        bool lower = less(f, h, heap[i].f, heap[i].h);
+
+        heap[i].f = f;
+        heap[i].h = h;
+
+        if (lower) siftUp(i);
+        else siftDown(i);
+    }
+
+    // Take a tile out of the heap wherever it is
+    void remove(int tile)
+    {
+        if (!contains(tile)) return;
+
+        int i = position[tile];
+        position[tile] = -1;
+
+        Entry last = heap.back();
+        heap.pop_back();
+
+        if (i < (int)heap.size()) {
+            heap[i] = last;
+            position[last.tile] = i;
+            siftUp(i);
+            siftDown(position[last.tile]);
+        }
+    }
+
+    // Lowest entry, without removing it
+    int top() const { return heap[0].tile; }
+    float topF() const { return heap[0].f; }
+    float topH() const { return heap[0].h; }
+
+    // Removes and returns the tile with the lowest f (then h)
+    int pop()
+    {
+        int first = heap[0].tile;
+        position[first] = -1;
+
+        Entry last = heap.back();
+        heap.pop_back();
+
+        if (!heap.empty()) {
+            heap[0] = last;
+            position[last.tile] = 0;
+            siftDown(0);
+        }
+        return first;
+    }
+
+private:
+    struct Entry {
+        int tile;
+        float f;
+        float h;
+    };
+
+    static bool less(float fa, float ha, float fb, float hb)
+    {
+        if (fa != fb) return fa < fb;
+        return ha < hb;
+    }
+
+    bool less(const Entry& a, const Entry& b) const
+    {
+        return less(a.f, a.h, b.f, b.h);
+    }
+
+    void siftUp(int i)
+    {
+        Entry e = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!less(e, heap[parent])) break;
+
+            heap[i] = heap[parent];
+            position[heap[i].tile] = i;
+            i = parent;
+        }
+        heap[i] = e;
+        position[e.tile] = i;
+    }
+
+    void siftDown(int i)
+    {
+        Entry e = heap[i];
+        int count = (int)heap.size();
+
+        while (true) {
+            int child = i * 2 + 1;
+            if (child >= count) break;
+
+            if (child + 1 < count && less(heap[child + 1], heap[child])) {
+                child++;
+            }
+            if (!less(heap[child], e)) break;
+
+            heap[i] = heap[child];
+            position[heap[i].tile] = i;
+            i = child;
+        }
+        heap[i] = e;
+        position[e.tile] = i;
+    }
+
+    std::vector<Entry> heap;
+    std::vector<int> position;
+};
@@ -0,0 +1,151 @@
+#include "JumpPointSearch.h"
+
+// Straight-line scans replace most single-tile expansions.
+// Horizontal moves only continue straight unless a wall ends beside them
+// (a forced neighbour). Vertical moves scan left and right at every step,
+// and stop wherever one of those scans finds a jump point.
+
+// Scan along the row from (x, y) in direction dx.
+// Returns the jump point's tile index, or -1 if the scan hits a wall.
+static int jumpHorizontal(const Map& theMap, int x, int y, int dx, const Node& dest)
+{
+	while (true) {
+		x += dx;
+
+		if (!isValid(theMap, x, y)) return -1;
+		if (isDestination(x, y, dest)) return theMap.getTiles().index(x, y);
+
+		// an opening above or below that the previous tile did not have
+		if (isValid(theMap, x, y - 1) && !isValid(theMap, x - dx, y - 1)) return theMap.getTiles().index(x, y);
+		if (isValid(theMap, x, y + 1) && !isValid(theMap, x - dx, y + 1)) return theMap.getTiles().index(x, y);
+	}
+}
+
+// Scan along the column from (x, y) in direction dy
+static int jumpVertical(const Map& theMap, int x, int y, int dy, const Node& dest)
+{
+	while (true) {
+		y += dy;
+
+		if (!isValid(theMap, x, y)) return -1;
+		if (isDestination(x, y, dest)) return theMap.getTiles().index(x, y);
+
+		if (jumpHorizontal(theMap, x, y, 1, dest) != -1 || jumpHorizontal(theMap, x, y, -1, dest) != -1) {
+			return theMap.getTiles().index(x, y);
+		}
+	}
+}
+
+// Default scratch state for callers that don't bring their own, one per thread
+static thread_local SearchContext defaultContext;
+
+vector<Node> jumpPointSearch(const Map& theMap, const Node& start, const Node& dest)
+{
+	return jumpPointSearch(theMap, start, dest, defaultContext);
+}
+
+vector<Node> jumpPointSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context)
+{
+	TilePath path;
+	jumpPointSearch(theMap, start, dest, context, path);
+	return toNodes(path);
+}
+
+bool jumpPointSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path)
+{
+	path.clear();
+
+	if (!isValid(theMap, dest.x, dest.y)) {
+		return false;
+	}
+
+	if (isDestination(start.x, start.y, dest)) {
+		return false;
+	}
+
+	if (isUnreachable(theMap, start, dest)) {
+		return false;
+	}
+
+	const int width = theMap.getWidth();
+	context.begin(width, theMap.getHeight());
+
+	const int startTile = start.y * width + start.x;
+	context.setNode(startTile, 0, startTile);
+
+	const float hStart = calculateH(start.x, start.y, dest);
+	context.openList.push(startTile, hStart, hStart);
+
+	bool found = false;
+
+	while (!context.openList.empty()) {
+		const int tile = context.openList.pop();
+		const int x = tile % width;
+		const int y = tile / width;
+
+		context.close(tile);
+
+		if (isDestination(x, y, dest)) {
+			found = true;
+			break;
+		}
+
+		// Direction we arrived from; the start node has none and tries all four
+		const int parentX = context.getParent(tile) % width;
+		const int parentY = context.getParent(tile) / width;
+		const int px = (x > parentX) - (x < parentX);
+		const int py = (y > parentY) - (y < parentY);
+
+		int successors[4];
+		int count = 0;
+
+		if (px != 0) {
+			// moving horizontally: keep going, plus any forced turn
+			successors[count++] = jumpHorizontal(theMap, x, y, px, dest);
+
+			if (isValid(theMap, x, y - 1) && !isValid(theMap, x - px, y - 1)) {
+				successors[count++] = jumpVertical(theMap, x, y, -1, dest);
+			}
+			if (isValid(theMap, x, y + 1) && !isValid(theMap, x - px, y + 1)) {
+				successors[count++] = jumpVertical(theMap, x, y, 1, dest);
+			}
+		}
+		else {
+			// moving vertically (or the start): keep going and branch sideways
+			if (py != 0) {
+				successors[count++] = jumpVertical(theMap, x, y, py, dest);
+			}
+			else {
+				successors[count++] = jumpVertical(theMap, x, y, -1, dest);
+				successors[count++] = jumpVertical(theMap, x, y, 1, dest);
+			}
+			successors[count++] = jumpHorizontal(theMap, x, y, 1, dest);
+			successors[count++] = jumpHorizontal(theMap, x, y, -1, dest);
+		}
+
+		for (int i = 0; i < count; i++) {
+			const int next = successors[i];
+			if (next == -1 || context.isClosed(next)) continue;
+
+			const int nx = next % width;
+			const int ny = next / width;
+
+			const int32_t gNew = context.getG(tile) + abs(nx - x) + abs(ny - y);
+
+			if (!context.isSeen(next) || context.getG(next) > gNew) {
+				const float hNew = calculateH(nx, ny, dest);
+
+				context.setNode(next, gNew, tile);
+				context.openList.push(next, gNew + hNew, hNew);
+			}
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	// makePath() fills in the straight runs between jump points
+	makePath(context, dest.y * width + dest.x, path);
+	return true;
+}
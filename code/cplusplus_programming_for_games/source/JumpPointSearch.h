@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+#include "AStarSearch.h"
+
+using namespace std;
+
+// Jump Point Search for the 4-connected, uniform-cost tile grid.
+// Same arguments and result as aStar(): the path runs tile by tile from the
+// start to dest, so Player and Enemy can follow either one.
+vector<Node> jumpPointSearch(const Map& theMap, const Node& start, const Node& dest);
+vector<Node> jumpPointSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context);
+bool jumpPointSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path);
@@ -0,0 +1,149 @@
+#include "LandmarkHeuristic.h"
+
+#include <chrono>
+
+#include "RegionLabels.h"
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+// Breadth-first steps from source to every tile, -1 where unreachable
+static void distancesFrom(const WalkBits& walk, int source, std::vector<int>& dist, std::vector<int>& frontier)
+{
+    const int width = walk.getWidth();
+    const int height = walk.getHeight();
+
+    dist.assign(width * height, -1);
+    frontier.clear();
+
+    dist[source] = 0;
+    frontier.push_back(source);
+
+    for (size_t head = 0; head < frontier.size(); head++) {
+        const int tile = frontier[head];
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if (!walk.get(nx, ny)) continue;
+
+            const int next = ny * width + nx;
+            if (dist[next] != -1) continue;
+
+            dist[next] = dist[tile] + 1;
+            frontier.push_back(next);
+        }
+    }
+}
+
+const int LandmarkHeuristic::MAX_DISTANCE;
+const uint16_t LandmarkHeuristic::UNREACHED;
+
+LandmarkHeuristic::LandmarkHeuristic(int landmarkCount_)
+    : landmarkCount(landmarkCount_)
+{
+}
+
+LandmarkHeuristic::Tables LandmarkHeuristic::compute(const WalkBits& walk, int landmarkCount, unsigned int version)
+{
+    Tables t;
+    t.version = version;
+
+    const int width = walk.getWidth();
+    const int tileCount = width * walk.getHeight();
+    if (tileCount > MAX_TILES || landmarkCount <= 0) return t;
+
+    // Landmarks only help inside the region they are in, so spend them all on
+    // the biggest one rather than on sealed-off pockets
+    RegionLabels regions;
+    regions.build(walk);
+
+    std::vector<int> regionSize(tileCount, 0);
+    int seed = -1;
+    for (int i = 0; i < tileCount; i++) {
+        int r = regions.region(i);
+        if (r == -1) continue;
+
+        regionSize[r]++;
+        if (seed == -1 || regionSize[r] > regionSize[regions.region(seed)]) seed = i;
+    }
+    if (seed == -1) return t;
+
+    std::vector<int> dist;
+    std::vector<int> frontier;
+
+    // Farthest-point selection: each landmark is the tile farthest from all
+    // the landmarks picked so far. The first is the tile farthest from the
+    // seed, which lands it on the edge of the region.
+    std::vector<int> nearest;
+    distancesFrom(walk, seed, nearest, frontier);
+
+    // Interleaved so one lookup reads every landmark's distance to a tile
+    // together; each landmark's column is written as soon as it's found
+    t.distance.resize((size_t)tileCount * landmarkCount);
+
+    for (int k = 0; k < landmarkCount; k++) {
+        int pick = -1;
+        for (int i = 0; i < tileCount; i++) {
+            if (nearest[i] > 0 && (pick == -1 || nearest[i] > nearest[pick])) pick = i;
+        }
+        if (pick == -1) break;
+
+        distancesFrom(walk, pick, dist, frontier);
+        t.landmarks.push_back(pick);
+
+        for (int i = 0; i < tileCount; i++) {
+            const int d = dist[i];
+            t.distance[(size_t)i * landmarkCount + k] = d < 0 ? UNREACHED : (uint16_t)(d < MAX_DISTANCE ? d : MAX_DISTANCE);
+
+            if (d != -1 && d < nearest[i]) nearest[i] = d;
+        }
+    }
+
+    t.count = (int)t.landmarks.size();
+
+    // Ran out of far tiles early: close up the unused columns. Every entry
+    // moves to an index no later than its own, so in place is safe.
+    if (t.count < landmarkCount) {
+        for (int i = 0; i < tileCount; i++) {
+            for (int k = 0; k < t.count; k++) {
+                t.distance[(size_t)i * t.count + k] = t.distance[(size_t)i * landmarkCount + k];
+            }
+        }
+        t.distance.resize((size_t)tileCount * t.count);
+    }
+
+    return t;
+}
+
+void LandmarkHeuristic::build(const Map& map)
+{
+    tables = compute(map.getWalkBits(), landmarkCount, map.getVersion());
+}
+
+void LandmarkHeuristic::update(const Map& map)
+{
+    if (pending.valid()) {
+        if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+        // installed even if the map has moved on since; isCurrent() keeps
+        // searches off it and another rebuild starts below
+        tables = pending.get();
+    }
+
+    if (isCurrent(map)) return;
+
+    // the worker gets its own copy of the walkable bits, so the game can keep
+    // breaking tiles while it runs
+    WalkBits walk = map.getWalkBits();
+    const int count = landmarkCount;
+    const unsigned int version = map.getVersion();
+
+    pending = std::async(std::launch::async, [walk, count, version]() {
+        return compute(walk, count, version);
+    });
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "Map.h"
+#include "WalkBits.h"
+
+// ALT heuristic (A*, Landmarks, Triangle inequality).
+// A few landmark tiles are chosen far apart, and the true step count from each
+// of them to every tile is stored. For any landmark L,
+// |dist(L, a) - dist(L, b)| <= dist(a, b), so the largest of those differences
+// is an admissible estimate. Unlike Manhattan distance it knows about walls.
+//
+// Attach it with Map::setLandmarks(); aStar() then uses it whenever the
+// tables match the map's version. After tiles break, update() rebuilds the
+// tables on a background thread and searches fall back to Manhattan
+// distance until the new ones are in.
+//
+// Distances take 2 bytes each, one per landmark per tile; ones past
+// MAX_DISTANCE are stored as MAX_DISTANCE, which only weakens the bound.
+class LandmarkHeuristic {
+public:
+    // 16 MB of tables with the default 8 landmarks; bigger maps get none and
+    // searches use Manhattan distance
+    static const int MAX_TILES = 1 << 20;
+    static const int MAX_DISTANCE = 0xFFFE;
+
+    explicit LandmarkHeuristic(int landmarkCount = 8);
+
+    // Build the tables now, on this thread
+    void build(const Map& map);
+
+    // Call once a frame. Installs a finished background build, and starts one
+    // if the map has changed since the tables were made.
+    void update(const Map& map);
+
+    // Tables describe the map as it is now
+    bool isCurrent(const Map& map) const
+    {
+        return tables.version == map.getVersion();
+    }
+
+    // Lower bound on the steps between two tiles (tile indices)
+    int lowerBound(int fromTile, int toTile) const
+    {
+        if (tables.count == 0) return 0;
+
+        const uint16_t* a = &tables.distance[(size_t)fromTile * tables.count];
+        const uint16_t* b = &tables.distance[(size_t)toTile * tables.count];
+
+        int best = 0;
+        for (int k = 0; k < tables.count; k++) {
+            if (a[k] == UNREACHED || b[k] == UNREACHED) continue;
+
+            int d = a[k] > b[k] ? a[k] - b[k] : b[k] - a[k];
+            if (d > best) best = d;
+        }
+        return best;
+    }
+
+    int getLandmarkCount() const { return tables.count; }
+    int getLandmark(int i) const { return tables.landmarks[i]; }
+
+private:
+    static const uint16_t UNREACHED = 0xFFFF;
+
+    struct Tables {
+        unsigned int version = 0;
+        int count = 0;
+        std::vector<int> landmarks;
+
+        // steps from landmark k to tile t at [t * count + k], UNREACHED if
+        // there's no path
+        std::vector<uint16_t> distance;
+    };
+
+    static Tables compute(const WalkBits& walk, int landmarkCount, unsigned int version);
+
+    int landmarkCount;
+    Tables tables;
+    std::future<Tables> pending;
+};
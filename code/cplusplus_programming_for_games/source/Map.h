@@ -2,11 +2,26 @@
 #include <SDL.h>
 #include <SDL_image.h>
 
+#include <vector>
+
+#include "Grid.h"
+#include "RegionLabels.h"
+#include "WalkBits.h"
+
 #define TILE_SIZE 32
 
+class FirstMoveTable;
+class GoalBounds;
+class RectangleGraph;
+class SubgoalGraph;
+class LandmarkHeuristic;
+
 class Map {
 public:
-    Map(SDL_Renderer* renderer) : renderer(renderer) {}
+    Map(SDL_Renderer* renderer) : renderer(renderer)
+    {
+        load(DEFAULT_WIDTH, DEFAULT_HEIGHT, defaultLevel());
+    }
 
     void init() {
         SDL_Surface* surface = IMG_Load("assets/Tiles/IndustrialTile_03.png");
@@ -23,11 +38,54 @@ public:
         SDL_FreeSurface(surface);
     }
 
+    // Replace the level with width x height tiles read row by row from data
+    void load(int width, int height, const int* data) {
+        tiles.resize(width, height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                tiles.at(x, y) = data[y * width + x];
+            }
+        }
+
+        walkable.resize(width, height);
+        moveCost.resize(width, height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int t = tiles.at(x, y);
+                walkable.set(x, y, !(t == 1 || t == 3));
+                moveCost.at(x, y) = (unsigned char)terrainCost(t);
+            }
+        }
+        regions.build(walkable);
+
+        version++;
+
+        // everything changed, so there is nothing to replay
+        loadVersion = version;
+        changeLog.clear();
+    }
+
     void update() {}
 
     void draw(int camX, int camY) {
-        for (int i = 0; i < 24; i++) {
-            for (int j = 0; j < 32; j++) {
+        // only visit the tiles inside the view
+        int viewW = 0, viewH = 0;
+        float scaleX = 1.0f, scaleY = 1.0f;
+        SDL_GetRendererOutputSize(renderer, &viewW, &viewH);
+        SDL_RenderGetScale(renderer, &scaleX, &scaleY);
+
+        int firstX = camX / TILE_SIZE;
+        int firstY = camY / TILE_SIZE;
+        int lastX = (camX + (int)(viewW / scaleX)) / TILE_SIZE;
+        int lastY = (camY + (int)(viewH / scaleY)) / TILE_SIZE;
+
+        if (firstX < 0) firstX = 0;
+        if (firstY < 0) firstY = 0;
+        if (lastX >= getWidth()) lastX = getWidth() - 1;
+        if (lastY >= getHeight()) lastY = getHeight() - 1;
+
+        for (int i = firstY; i <= lastY; i++) {
+            for (int j = firstX; j <= lastX; j++) {
 
                 int worldX = j * TILE_SIZE;
                 int worldY = i * TILE_SIZE;
@@ -36,10 +94,10 @@ public:
 
                 SDL_RenderCopy(renderer, backgroundTexture, nullptr, &dest);
 
-                if (MAP_DATA[i][j] == 1) {
+                if (tiles.at(j, i) == 1) {
                     SDL_RenderCopy(renderer, crateTexture, nullptr, &dest);
                 }
-                else if (MAP_DATA[i][j] == 3) {
+                else if (tiles.at(j, i) == 3) {
                     SDL_RenderCopy(renderer, breakableTexture, nullptr, &dest);
                 }
             }
@@ -53,29 +111,133 @@ public:
     }
 
     const int* operator[] (int row) const {
-        return MAP_DATA[row];
+        return tiles.row(row);
     }
 
-    // Solid tiles: 1 (crate/wall) and 3 (breakable)
-    bool isWallAtPixel(int px, int py) const {
-        int tx = px / TILE_SIZE;
-        int ty = py / TILE_SIZE;
+    int getWidth() const { return tiles.getWidth(); }
+    int getHeight() const { return tiles.getHeight(); }
+
+    // Size of the built-in level
+    static const int DEFAULT_WIDTH = 32;
+    static const int DEFAULT_HEIGHT = 24;
+
+    const Grid<int>& getTiles() const { return tiles; }
+
+    // Bumped whenever a tile changes, so cached pathing data can tell it is stale
+    unsigned int getVersion() const { return version; }
 
-        if (tx < 0 || ty < 0 || tx >= 32 || ty >= 24) return true;
+    // Area of the map touched by one change, in tiles
+    struct DirtyRect {
+        int x;
+        int y;
+        int w;
+        int h;
+    };
 
-        int t = MAP_DATA[ty][tx];
-        return (t == 1 || t == 3);
+    // Append the rectangle of every change after sinceVersion to dirty.
+    // Returns false if the level was reloaded since then, in which case the
+    // caller has to rebuild from scratch.
+    bool getDirtySince(unsigned int sinceVersion, std::vector<DirtyRect>& dirty) const {
+        if (sinceVersion < loadVersion) return false;
+
+        for (size_t i = sinceVersion - loadVersion; i < changeLog.size(); i++) {
+            dirty.push_back(changeLog[i]);
+        }
+        return true;
+    }
+
+    // As getDirtySince(), as the index of every tile changed
+    bool getChangesSince(unsigned int sinceVersion, std::vector<int>& changed) const {
+        if (sinceVersion < loadVersion) return false;
+
+        for (size_t i = sinceVersion - loadVersion; i < changeLog.size(); i++) {
+            const DirtyRect& r = changeLog[i];
+            for (int y = r.y; y < r.y + r.h; y++) {
+                for (int x = r.x; x < r.x + r.w; x++) {
+                    changed.push_back(tiles.index(x, y));
+                }
+            }
+        }
+        return true;
+    }
+
+    bool inBounds(int tx, int ty) const {
+        return tiles.inBounds(tx, ty);
+    }
+
+    // Solid tiles: 1 (crate/wall) and 3 (breakable). Outside the map is solid.
+    bool isBlocked(int tx, int ty) const {
+        if (!tiles.inBounds(tx, ty)) return true;
+
+        return !walkable.get(tx, ty);
+    }
+
+    // Cost of stepping onto a tile, 0 if it can't be entered at any cost.
+    // Unlike isBlocked(), breakable tiles count: smashing through one costs
+    // BREAKABLE_COST steps' worth of time.
+    int getMoveCost(int tx, int ty) const {
+        if (!tiles.inBounds(tx, ty)) return 0;
+
+        return moveCost.at(tx, ty);
+    }
+
+    static const int FLOOR_COST = 1;
+    static const int BREAKABLE_COST = 8;
+    static const int MAX_MOVE_COST = BREAKABLE_COST;
+
+    // Walkability as one bit per tile, kept in step with the tiles
+    const WalkBits& getWalkBits() const { return walkable; }
+
+    // Distance tables aStar() may use as its heuristic; owned by the caller
+    void setLandmarks(const LandmarkHeuristic* l) { landmarks = l; }
+    const LandmarkHeuristic* getLandmarks() const { return landmarks; }
+
+    // First-move table SearchMode::FirstMove answers from; owned by the caller
+    void setFirstMoves(const FirstMoveTable* table) { firstMoves = table; }
+    const FirstMoveTable* getFirstMoves() const { return firstMoves; }
+
+    // Per-move bounding boxes aStar() prunes neighbours with; owned by the caller
+    void setGoalBounds(const GoalBounds* bounds) { goalBounds = bounds; }
+    const GoalBounds* getGoalBounds() const { return goalBounds; }
+
+    // Corner graph SearchMode::Subgoal searches over; owned by the caller
+    void setSubgoals(const SubgoalGraph* graph) { subgoals = graph; }
+    const SubgoalGraph* getSubgoals() const { return subgoals; }
+
+    // Empty-rectangle cover SearchMode::Rectangles prunes with; owned by the caller
+    void setRectangles(const RectangleGraph* graph) { rectangles = graph; }
+    const RectangleGraph* getRectangles() const { return rectangles; }
+
+    // Connected region of a walkable tile, -1 if blocked or off the map.
+    // Tiles in different regions have no path between them.
+    int getRegion(int tx, int ty) const {
+        if (!tiles.inBounds(tx, ty)) return -1;
+
+        return regions.region(tiles.index(tx, ty));
+    }
+
+    bool isWallAtPixel(int px, int py) const {
+        if (px < 0 || py < 0) return true;
+
+        return isBlocked(px / TILE_SIZE, py / TILE_SIZE);
     }
 
     // Break tile 3 into tile 0. Returns true if a tile was broken.
     bool breakTileAtPixel(int px, int py) {
+        if (px < 0 || py < 0) return false;
+
         int tx = px / TILE_SIZE;
         int ty = py / TILE_SIZE;
 
-        if (tx < 0 || ty < 0 || tx >= 32 || ty >= 24) return false;
+        if (!tiles.inBounds(tx, ty)) return false;
 
-        if (MAP_DATA[ty][tx] == 3) {
-            MAP_DATA[ty][tx] = 0;
+        if (tiles.at(tx, ty) == 3) {
+            tiles.at(tx, ty) = 0;
+            walkable.set(tx, ty, true);
+            moveCost.at(tx, ty) = (unsigned char)terrainCost(0);
+            regions.open(walkable, tx, ty);
+            version++;
+            changeLog.push_back(DirtyRect{ tx, ty, 1, 1 });
             return true;
         }
         return false;
@@ -87,31 +249,55 @@ private:
     SDL_Texture* crateTexture = nullptr;
     SDL_Texture* breakableTexture = nullptr;
 
+    Grid<int> tiles;
+    WalkBits walkable;
+    Grid<unsigned char> moveCost;
+    RegionLabels regions;
+    const LandmarkHeuristic* landmarks = nullptr;
+    const FirstMoveTable* firstMoves = nullptr;
+    const GoalBounds* goalBounds = nullptr;
+    const SubgoalGraph* subgoals = nullptr;
+    const RectangleGraph* rectangles = nullptr;
+    unsigned int version = 0;
+
+    // changeLog[i] is the area changed by version loadVersion + i + 1
+    unsigned int loadVersion = 0;
+    std::vector<DirtyRect> changeLog;
+
+    static int terrainCost(int tile) {
+        if (tile == 1) return 0;
+        if (tile == 3) return BREAKABLE_COST;
+        return FLOOR_COST;
+    }
+
 	// Tilemap
-	int MAP_DATA[24][32] = {
-		{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
-		{ 1,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1 },
-		{ 1,0,0,0,1,0,0,0,0,0,1,0,1,1,1,1,0,1,0,1,0,1,0,1,0,0,1,0,0,0,0,1 },
-		{ 1,0,0,0,1,1,1,1,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1 },
-		{ 1,0,0,0,0,0,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1 },
-		{ 1,3,1,1,1,1,1,1,1,0,1,1,1,1,1,1,0,0,0,1,0,0,0,3,0,0,1,0,1,0,0,1 },
-		{ 1,0,1,0,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,1,1,0,1,0,0,1 },
-		{ 1,0,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,1,1,1,1,1,1,1,1,0,1,0,0,1 },
-		{ 1,0,1,0,0,0,0,0,0,0,0,0,1,0,0,0,1,0,0,1,0,0,0,0,0,0,1,0,1,0,0,1 },
-		{ 1,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,1,1,1,1,1,1,1,0,1,1,1,0,0,1 },
-		{ 1,1,1,0,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,1,0,1,1,1,1,0,1,1,1,1,1,0,1,1,0,1,1,1,0,1,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,1,0,1,0,0,1,3,0,0,0,0,1,0,0,1,0,1,1,1,0,1,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,1,0,1,0,0,1,3,0,0,0,0,1,0,0,1,0,1,0,1,0,1,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,1,1,1,1,0,1,0,1,1,1,1,1,0,0,1,0,1,1,1,0,1,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,3,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0,1,0,1,0,1,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,1,1,1,0,0,0,0,0,1,1,1,0,1,1,1,0,1,0,1,0,1,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,0,1,0,1,0,1,1,1,1,1,1 },
-		{ 1,0,0,0,1,0,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,0,1,0,1,0,0,0,0,0,0,1 },
-		{ 1,0,1,0,1,0,0,0,3,0,0,0,0,1,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,1,0,1 },
-		{ 1,0,1,0,1,0,0,0,0,0,0,0,0,0,3,0,1,1,0,0,1,1,1,1,1,1,1,1,1,1,0,1 },
-		{ 1,0,1,0,1,0,0,0,0,0,0,0,0,1,1,0,1,1,0,0,1,1,0,1,1,1,0,0,1,0,0,1 },
-		{ 1,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,1,0,0,1 },
-		{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
-	};
+	static const int* defaultLevel() {
+		static const int MAP_DATA[DEFAULT_HEIGHT][DEFAULT_WIDTH] = {
+			{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
+			{ 1,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,1 },
+			{ 1,0,0,0,1,0,0,0,0,0,1,0,1,1,1,1,0,1,0,1,0,1,0,1,0,0,1,0,0,0,0,1 },
+			{ 1,0,0,0,1,1,1,1,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1 },
+			{ 1,0,0,0,0,0,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1 },
+			{ 1,3,1,1,1,1,1,1,1,0,1,1,1,1,1,1,0,0,0,1,0,0,0,3,0,0,1,0,1,0,0,1 },
+			{ 1,0,1,0,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,1,1,0,1,0,0,1 },
+			{ 1,0,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0,0,0,1,1,1,1,1,1,1,1,0,1,0,0,1 },
+			{ 1,0,1,0,0,0,0,0,0,0,0,0,1,0,0,0,1,0,0,1,0,0,0,0,0,0,1,0,1,0,0,1 },
+			{ 1,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,1,1,1,1,1,1,1,0,1,1,1,0,0,1 },
+			{ 1,1,1,0,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,1,0,1,1,1,1,0,1,1,1,1,1,0,1,1,0,1,1,1,0,1,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,1,0,1,0,0,1,3,0,0,0,0,1,0,0,1,0,1,1,1,0,1,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,1,0,1,0,0,1,3,0,0,0,0,1,0,0,1,0,1,0,1,0,1,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,1,1,1,1,0,1,0,1,1,1,1,1,0,0,1,0,1,1,1,0,1,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,3,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0,1,0,1,0,1,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,1,1,1,0,0,0,0,0,1,1,1,0,1,1,1,0,1,0,1,0,1,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,0,1,0,1,0,1,1,1,1,1,1 },
+			{ 1,0,0,0,1,0,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,0,1,0,1,0,0,0,0,0,0,1 },
+			{ 1,0,1,0,1,0,0,0,3,0,0,0,0,1,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,1,0,1 },
+			{ 1,0,1,0,1,0,0,0,0,0,0,0,0,0,3,0,1,1,0,0,1,1,1,1,1,1,1,1,1,1,0,1 },
+			{ 1,0,1,0,1,0,0,0,0,0,0,0,0,1,1,0,1,1,0,0,1,1,0,1,1,1,0,0,1,0,0,1 },
+			{ 1,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,1,0,0,1 },
+			{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
+		};
+		return &MAP_DATA[0][0];
+	}
 };
\ No newline at end of file
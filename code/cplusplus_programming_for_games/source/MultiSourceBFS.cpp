@@ -0,0 +1,147 @@
+#include "MultiSourceBFS.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static int lowestBit(uint64_t w)
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, w);
+    return (int)bit;
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+const uint16_t MultiSourceBFS::UNREACHED;
+const int MultiSourceBFS::MAX_DISTANCE;
+
+void MultiSourceBFS::run(const Map& map, const int* sources, int count)
+{
+    width = map.getWidth();
+    height = map.getHeight();
+    sourceCount = count < MAX_SOURCES ? count : MAX_SOURCES;
+
+    const int stride = width + 2;
+    const int padded = stride * (height + 2);
+
+    cells.assign(padded, Cell());
+
+    // all ones where walkable, so masking with it is a single AND
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            cells[(y + 1) * stride + x + 1].open = map.isBlocked(x, y) ? 0 : ~(uint64_t)0;
+        }
+    }
+
+    dist.assign((size_t)width * height * sourceCount, UNREACHED);
+
+    // padded rows the frontier is on
+    int top = height + 1;
+    int bottom = 0;
+
+    frontierTiles.clear();
+    for (int k = 0; k < sourceCount; k++) {
+        const int tile = sources[k];
+        const int row = tile / width + 1;
+        const int p = row * stride + tile % width + 1;
+
+        if (cells[p].frontier == 0) frontierTiles.push_back(p);
+        cells[p].frontier |= (uint64_t)1 << k;
+        cells[p].visited |= (uint64_t)1 << k;
+        dist[(size_t)tile * sourceCount + k] = 0;
+
+        if (row < top) top = row;
+        if (row > bottom) bottom = row;
+    }
+
+    const int offset[4] = { -stride, 1, stride, -1 };
+
+    // levels stops short of UNREACHED, so a stored distance never wraps onto it
+    for (int levels = 1; levels <= MAX_DISTANCE && !frontierTiles.empty(); levels++) {
+        reachedTiles.clear();
+
+        // the frontier can only spread one row up or down
+        const int first = top > 1 ? top - 1 : 1;
+        const int last = bottom < height ? bottom + 1 : height;
+
+        if ((int)frontierTiles.size() * 4 >= (last - first + 1) * width) {
+            // Dense frontier: sweep every tile of the band, pulling in its
+            // neighbours' frontier bits. No branches but the empty test.
+            for (int y = first; y <= last; y++) {
+                for (int p = y * stride + 1; p <= y * stride + width; p++) {
+                    const uint64_t bits = (cells[p - stride].frontier | cells[p + stride].frontier | cells[p - 1].frontier | cells[p + 1].frontier)
+                        & cells[p].open & ~cells[p].visited;
+                    cells[p].reached = bits;
+                    if (bits) reachedTiles.push_back(p);
+                }
+            }
+        }
+        else {
+            // Sparse frontier: push each frontier tile's bits to its neighbours
+            for (int p : frontierTiles) {
+                const uint64_t bits = cells[p].frontier;
+
+                for (int d = 0; d < 4; d++) {
+                    const int n = p + offset[d];
+                    const uint64_t add = bits & cells[n].open & ~cells[n].visited;
+                    if (add == 0) continue;
+
+                    if (cells[n].reached == 0) reachedTiles.push_back(n);
+                    cells[n].reached |= add;
+                }
+            }
+        }
+
+        for (int p : frontierTiles) cells[p].frontier = 0;
+
+        // the tiles just reached are the next frontier
+        top = height + 1;
+        bottom = 0;
+
+        for (int n : reachedTiles) {
+            uint64_t bits = cells[n].reached;
+            cells[n].reached = 0;
+
+            cells[n].visited |= bits;
+            cells[n].frontier = bits;
+
+            const int row = n / stride;
+            if (row < top) top = row;
+            if (row > bottom) bottom = row;
+
+            uint16_t* d = &dist[(size_t)((row - 1) * width + n % stride - 1) * sourceCount];
+            while (bits) {
+                d[lowestBit(bits)] = (uint16_t)levels;
+                bits &= bits - 1;
+            }
+        }
+
+        frontierTiles.swap(reachedTiles);
+    }
+}
+
+int MultiSourceBFS::firstStep(int k, int tile) const
+{
+    const int d = distance(k, tile);
+    if (d <= 0) return -1;
+
+    const int x = tile % width;
+    const int y = tile / width;
+
+    for (int i = 0; i < 4; i++) {
+        const int nx = x + DIR_X[i];
+        const int ny = y + DIR_Y[i];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+        const int next = ny * width + nx;
+        if (distance(k, next) == d - 1) return next;
+    }
+    return -1;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Map.h"
+
+// Breadth-first search from up to 64 sources at once. Every tile holds a
+// 64-bit mask with bit k set once source k has reached it, so one sweep
+// moves all 64 frontiers a step with a few word-wide ORs and AND-NOTs:
+//
+//   reached = (mask of each neighbour on the frontier) & ~visited
+//
+// A sparse frontier pushes from a list of its tiles; a dense one sweeps the
+// rows it spans instead. Either way a tile is handled once per distinct
+// distance it is from the sources, not once per source, so sources close
+// together cost little more than one search. Sources spread across a big
+// map reach most tiles at many different levels and gain little.
+//
+// Distances are kept per tile and source afterwards (2 bytes each), for
+// distance() and firstStep() lookups; GameLoop uses them to check every
+// spawn can reach the player. Tiles more than MAX_DISTANCE steps from a
+// source count as unreachable from it, so the map needs no size limit.
+class MultiSourceBFS {
+public:
+    static const int MAX_SOURCES = 64;
+    static const int MAX_DISTANCE = 0xFFFE;
+
+    // Steps from each of count source tiles (tile indices, count <= 64) to
+    // every tile of the map as it is now
+    void run(const Map& map, const int* sources, int count);
+
+    // Steps from source k to tile, -1 if it can't be reached
+    int distance(int k, int tile) const
+    {
+        const uint16_t d = dist[(size_t)tile * sourceCount + k];
+        return d == UNREACHED ? -1 : d;
+    }
+
+    // Next tile from tile along a shortest path to source k, -1 if tile is
+    // source k or can't reach it
+    int firstStep(int k, int tile) const;
+
+    int getSourceCount() const { return sourceCount; }
+
+private:
+    static const uint16_t UNREACHED = 0xFFFF;
+
+    int width = 0;
+    int height = 0;
+    int sourceCount = 0;
+
+    // Masks over the map with a one-tile wall border, so neighbours need no
+    // bounds checks; padded index (y + 1) * (width + 2) + x + 1
+    struct Cell {
+        uint64_t open = 0;
+        uint64_t visited = 0;
+        uint64_t frontier = 0;
+        uint64_t reached = 0;
+    };
+    std::vector<Cell> cells;
+    std::vector<int> frontierTiles;
+    std::vector<int> reachedTiles;
+
+    // [tile * sourceCount + k], map tile indices
+    std::vector<uint16_t> dist;
+};
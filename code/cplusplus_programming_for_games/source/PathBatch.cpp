@@ -0,0 +1,101 @@
+#include "PathBatch.h"
+
+// Below this many queries the threads cost more to wake than they save
+static const int MIN_PARALLEL_QUERIES = 4;
+
+PathWorkerPool::PathWorkerPool(int workerCount)
+    : nextQuery(0)
+{
+    if (workerCount <= 0) {
+        workerCount = (int)std::thread::hardware_concurrency() - 1;
+        if (workerCount < 1) workerCount = 1;
+    }
+
+    contexts.resize(workerCount + 1);
+
+    for (int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&PathWorkerPool::workerLoop, this, i);
+    }
+}
+
+PathWorkerPool::~PathWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quitting = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+void PathWorkerPool::drain(SearchContext& context)
+{
+    while (true) {
+        const int i = nextQuery.fetch_add(1);
+        if (i >= count) break;
+
+        const PathQuery& q = queries[i];
+        findPath(*map, q.start, q.dest, q.mode, context, results[i].path);
+        results[i].expansions = context.getExpansions();
+    }
+}
+
+void PathWorkerPool::workerLoop(int index)
+{
+    unsigned int seenBatch = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quitting || batch != seenBatch; });
+
+            if (quitting) return;
+            seenBatch = batch;
+        }
+
+        drain(contexts[index]);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        finished.notify_one();
+    }
+}
+
+void PathWorkerPool::run(const Map& theMap, const PathQuery* batchQueries, PathResult* batchResults, int batchCount)
+{
+    if (batchCount <= 0) return;
+
+    map = &theMap;
+    queries = batchQueries;
+    results = batchResults;
+    count = batchCount;
+    nextQuery = 0;
+
+    if (batchCount < MIN_PARALLEL_QUERIES) {
+        drain(contexts.back());
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busyWorkers = (int)workers.size();
+        batch++;
+    }
+    wake.notify_all();
+
+    drain(contexts.back());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return busyWorkers == 0; });
+}
+
+void aStarBatch(const Map& map, const PathQuery* queries, PathResult* results, int count)
+{
+    static PathWorkerPool pool;
+    pool.run(map, queries, results, count);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Map.h"
+#include "SearchContext.h"
+
+// One independent start/goal search in a batch
+struct PathQuery {
+    Node start;
+    Node dest;
+    SearchMode mode = SearchMode::AStar;
+};
+
+struct PathResult {
+    // storage is kept from batch to batch
+    TilePath path;
+
+    // tiles closed by the search, for profiling
+    int expansions = 0;
+};
+
+// Fixed set of threads that run path queries in batches. Every worker
+// searches with its own SearchContext, and the calling thread joins in too.
+class PathWorkerPool {
+public:
+    // workerCount 0 uses one thread per spare hardware core
+    explicit PathWorkerPool(int workerCount = 0);
+    ~PathWorkerPool();
+
+    PathWorkerPool(const PathWorkerPool&) = delete;
+    PathWorkerPool& operator=(const PathWorkerPool&) = delete;
+
+    // Run count queries, writing results[i] for queries[i]. The map must not
+    // change until this returns, which is once every result is written.
+    void run(const Map& map, const PathQuery* queries, PathResult* results, int count);
+
+    int getWorkerCount() const { return (int)workers.size(); }
+
+private:
+    void workerLoop(int index);
+
+    // Take queries until none are left
+    void drain(SearchContext& context);
+
+    std::vector<std::thread> workers;
+
+    // contexts[i] for worker i, the last one for the calling thread
+    std::vector<SearchContext> contexts;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    // current batch
+    const Map* map = nullptr;
+    const PathQuery* queries = nullptr;
+    PathResult* results = nullptr;
+    int count = 0;
+    std::atomic<int> nextQuery;
+
+    unsigned int batch = 0;
+    int busyWorkers = 0;
+    bool quitting = false;
+};
+
+// Run many searches at once on a shared pool. Results go into the caller's
+// buffer, results[i] answering queries[i].
+void aStarBatch(const Map& map, const PathQuery* queries, PathResult* results, int count);
@@ -0,0 +1,131 @@
+#include "PathBroker.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// start in the top 32 bits, then the goal in 24 (enough for 4096x4096
+// levels), then the mode
+static const int MODE_BITS = 8;
+static_assert(SEARCH_MODE_COUNT <= (1 << MODE_BITS), "SearchMode no longer fits in PathBroker keys");
+
+unsigned long long PathBroker::makeKey(int startTile, int goalTile, SearchMode mode)
+{
+    return ((unsigned long long)(unsigned int)startTile << 32)
+        | ((unsigned long long)(unsigned int)goalTile << MODE_BITS)
+        | (unsigned long long)mode;
+}
+
+void PathBroker::clear()
+{
+    requests.clear();
+    queries.clear();
+    shares.clear();
+    byKey.clear();
+    onPath.clear();
+}
+
+int PathBroker::submit(const Map& map, const PathQuery& query)
+{
+    const int width = map.getWidth();
+    const unsigned long long key = makeKey(query.start.y * width + query.start.x,
+        query.dest.y * width + query.dest.x, query.mode);
+
+    // counters start over with the first request of a tick, so a tick
+    // without any leaves the last busy one showing
+    if (requests.empty()) stats = Stats();
+    stats.requests++;
+
+    auto found = byKey.find(key);
+    if (found != byKey.end()) {
+        stats.duplicates++;
+        requests.push_back(found->second);
+    }
+    else {
+        const int unique = (int)queries.size();
+        byKey.emplace(key, unique);
+        queries.push_back(query);
+        shares.push_back(Share());
+        requests.push_back(unique);
+    }
+    return (int)requests.size() - 1;
+}
+
+void PathBroker::indexPath(int result, const PathQuery& query, int width)
+{
+    const TilePath& path = results[result].path;
+    const int goalTile = query.dest.y * width + query.dest.x;
+
+    // the last tile is the goal itself, which never needs a path
+    for (int i = 0; i + 1 < path.size(); i++) {
+        Share share;
+        share.result = result;
+        share.offset = i;
+        onPath.emplace(makeKey(path.tileAt(i), goalTile, query.mode), share);
+    }
+}
+
+void PathBroker::run(const Map& map, PathWorkerPool& workers)
+{
+    const int width = map.getWidth();
+
+    // Farthest first: long paths are the ones nearer starts can lie on
+    order.resize(queries.size());
+    for (int i = 0; i < (int)order.size(); i++) order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        const PathQuery& qa = queries[a];
+        const PathQuery& qb = queries[b];
+        return std::abs(qa.start.x - qa.dest.x) + std::abs(qa.start.y - qa.dest.y)
+            > std::abs(qb.start.x - qb.dest.x) + std::abs(qb.start.y - qb.dest.y);
+    });
+
+    // Search in waves of one query per thread, so the pool stays busy while
+    // each wave's paths can still answer the requests behind it
+    const int waveSize = workers.getWorkerCount() + 1;
+    size_t next = 0;
+
+    while (next < order.size()) {
+        wave.clear();
+        waveOwners.clear();
+
+        while (next < order.size() && (int)wave.size() < waveSize) {
+            const int unique = order[next++];
+            const PathQuery& q = queries[unique];
+
+            auto found = onPath.find(makeKey(q.start.y * width + q.start.x,
+                q.dest.y * width + q.dest.x, q.mode));
+            if (found != onPath.end()) {
+                shares[unique] = found->second;
+                stats.suffixHits++;
+                continue;
+            }
+
+            wave.push_back(q);
+            waveOwners.push_back(unique);
+        }
+
+        if (wave.empty()) continue;
+
+        const int first = stats.searches;
+        stats.searches += (int)wave.size();
+        if ((int)results.size() < stats.searches) results.resize(stats.searches);
+
+        workers.run(map, wave.data(), results.data() + first, (int)wave.size());
+
+        for (int i = 0; i < (int)wave.size(); i++) {
+            shares[waveOwners[i]].result = first + i;
+            shares[waveOwners[i]].offset = 0;
+            indexPath(first + i, wave[i], width);
+        }
+    }
+}
+
+const TilePath& PathBroker::getPath(int request) const
+{
+    return results[shares[requests[request]].result].path;
+}
+
+int PathBroker::getOffset(int request) const
+{
+    return shares[requests[request]].offset;
+}
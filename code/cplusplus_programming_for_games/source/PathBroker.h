@@ -0,0 +1,84 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "PathBatch.h"
+
+// Collects the path requests made during one tick and answers them with as
+// few searches as possible. Identical (start, goal, mode) requests share one
+// search. Requests are searched farthest first, and one whose start lies on
+// a path already found to the same goal takes the rest of that path instead
+// of searching. Enemies chasing the player mostly end up on each other's
+// routes, so most of a tick's requests come back without a search.
+//
+// Every request sharing a search gets the same result object, read through
+// getPath() from getOffset() on.
+class PathBroker {
+public:
+    struct Stats {
+        int requests = 0;   // submitted this tick
+        int searches = 0;   // actually run
+        int duplicates = 0; // same start, goal and mode as an earlier request
+        int suffixHits = 0; // start was on a path found this tick
+
+        // requests answered without a search of their own
+        int coalesced() const { return duplicates + suffixHits; }
+    };
+
+    // Forget the previous tick's requests; their results become invalid
+    void clear();
+
+    // Queue a request and return its handle for getPath() / getOffset()
+    int submit(const Map& map, const PathQuery& query);
+
+    // Answer every request submitted since clear(), searching on the pool.
+    // The map must not change in between.
+    void run(const Map& map, PathWorkerPool& workers);
+
+    // Result shared by every request it answers; empty if there's no route
+    const TilePath& getPath(int request) const;
+
+    // Where this request's start is along getPath()
+    int getOffset(int request) const;
+
+    int getRequestCount() const { return (int)requests.size(); }
+
+    // Counters for the last tick that had requests
+    const Stats& getStats() const { return stats; }
+
+private:
+    // A result and how far along it a request starts
+    struct Share {
+        int result = -1;
+        int offset = 0;
+    };
+
+    static unsigned long long makeKey(int startTile, int goalTile, SearchMode mode);
+
+    // Index every tile of a found path so later starts on it can share it
+    void indexPath(int result, const PathQuery& query, int width);
+
+    // unique request each submitted request maps to
+    std::vector<int> requests;
+
+    // unique requests and the share answering each
+    std::vector<PathQuery> queries;
+    std::vector<Share> shares;
+    std::unordered_map<unsigned long long, int> byKey;
+
+    // unique requests, farthest from their goal first
+    std::vector<int> order;
+
+    // one per search run; storage is kept from tick to tick
+    std::vector<PathResult> results;
+
+    // searches handed to the pool together
+    std::vector<PathQuery> wave;
+    std::vector<int> waveOwners;
+
+    // (tile, goal, mode) -> path found this tick that passes through tile
+    std::unordered_map<unsigned long long, Share> onPath;
+
+    Stats stats;
+};
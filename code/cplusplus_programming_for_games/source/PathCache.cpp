@@ -0,0 +1,146 @@
+#include "PathCache.h"
+
+PathCache::PathCache(size_t capacity_)
+    : capacity(capacity_), spare(capacity_), byKey(capacity_), byTile(capacity_ * TILES_PER_ENTRY)
+{
+}
+
+const size_t PathCache::TILES_PER_ENTRY;
+
+// start in the top 32 bits, then the goal in 24 (enough for 4096x4096
+// levels), then the mode. Entries never outlive a map version, so the
+// version needn't be in the key.
+static const int MODE_BITS = 8;
+static_assert(SEARCH_MODE_COUNT <= (1 << MODE_BITS), "SearchMode no longer fits in PathCache keys");
+
+unsigned long long PathCache::makeKey(int startTile, int goalTile, SearchMode mode)
+{
+    return ((unsigned long long)(unsigned int)startTile << 32)
+        | ((unsigned long long)(unsigned int)goalTile << MODE_BITS)
+        | (unsigned long long)mode;
+}
+
+void PathCache::clear()
+{
+    spare.splice(spare.end(), entries);
+    byKey.clear();
+    byTile.clear();
+}
+
+std::vector<Node> PathCache::findPath(const Map& map, const Node& start, const Node& dest, SearchMode mode)
+{
+    TilePath path;
+    findPath(map, start, dest, mode, path);
+    return toNodes(path);
+}
+
+bool PathCache::findPath(const Map& map, const Node& start, const Node& dest, SearchMode mode, TilePath& path)
+{
+    if (map.getVersion() != mapVersion) {
+        stats.invalidations += (int)entries.size();
+        clear();
+        mapVersion = map.getVersion();
+    }
+
+    path.clear();
+
+    if (start.x == dest.x && start.y == dest.y) {
+        return false;
+    }
+
+    // Weighted, diagonal and any-angle routes differ from the shortest
+    // tile-by-tile ones the entries hold
+    if (!isShortestTileMode(mode)) {
+        stats.misses++;
+        return ::findPath(map, start, dest, mode, path);
+    }
+
+    const int width = map.getWidth();
+    const int startTile = start.y * width + start.x;
+    const int goalTile = dest.y * width + dest.x;
+    const unsigned long long key = makeKey(startTile, goalTile, mode);
+
+    EntryIt* found = byKey.find(key);
+    if (found) {
+        stats.hits++;
+        entries.splice(entries.begin(), entries, *found);
+
+        const std::vector<int>& tiles = (*found)->tiles;
+        path.assign(width, tiles.data(), (int)tiles.size());
+        return !path.empty();
+    }
+
+    PathPosition* onPath = byTile.find(key);
+    if (onPath) {
+        stats.suffixHits++;
+        EntryIt it = onPath->entry;
+        entries.splice(entries.begin(), entries, it);
+
+        const size_t index = onPath->index;
+        path.assign(width, it->tiles.data() + index, (int)(it->tiles.size() - index));
+        return true;
+    }
+
+    stats.misses++;
+
+    bool result = ::findPath(map, start, dest, mode, path);
+    insert(key, path, goalTile, mode);
+    return result;
+}
+
+void PathCache::insert(unsigned long long key, const TilePath& path, int goalTile, SearchMode mode)
+{
+    if (capacity == 0) return;
+
+    // Recycle the least recently used entry when full, so its list node and
+    // tile storage are reused rather than freed and allocated again
+    if (entries.size() >= capacity) {
+        EntryIt last = std::prev(entries.end());
+        unindex(last);
+        entries.splice(entries.begin(), entries, last);
+        stats.evictions++;
+    }
+    else {
+        entries.splice(entries.begin(), spare, spare.begin());
+    }
+
+    EntryIt it = entries.begin();
+    it->key = key;
+    it->mode = mode;
+    it->tiles.resize(path.size());
+    for (int i = 0; i < path.size(); i++) {
+        it->tiles[i] = path.tileAt(i);
+    }
+    *byKey.insert(key) = it;
+
+    // every tile but the goal can start a suffix of this path, as long as
+    // the index has room
+    for (size_t i = 0; i + 1 < it->tiles.size(); i++) {
+        PathPosition* pos = byTile.insert(makeKey(it->tiles[i], goalTile, mode));
+        if (!pos) break;
+
+        pos->entry = it;
+        pos->index = i;
+    }
+}
+
+void PathCache::unindex(EntryIt it)
+{
+    const std::vector<int>& tiles = it->tiles;
+
+    if (!tiles.empty()) {
+        const int goalTile = tiles.back();
+
+        for (size_t i = 0; i + 1 < tiles.size(); i++) {
+            const unsigned long long tileKey = makeKey(tiles[i], goalTile, it->mode);
+            PathPosition* pos = byTile.find(tileKey);
+
+            // a newer path may have taken over this slot
+            if (pos && pos->entry == it) {
+                byTile.erase(tileKey);
+            }
+        }
+    }
+
+    byKey.erase(it->key);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "FlatMap.h"
+#include "Map.h"
+
+// LRU cache of finished paths keyed on (start tile, goal tile, search mode).
+// Breaking a tile bumps the map version, so every older entry is dropped on
+// the next lookup. A request whose start lies on a cached path to the same
+// goal, found with the same mode, gets the rest of that path without
+// searching.
+//
+// The entries and both indexes are allocated up front for capacity paths,
+// so misses and invalidations reuse storage rather than allocating. An
+// entry's tile vector only grows when it's handed a path longer than any it
+// has held before. The suffix index has room for TILES_PER_ENTRY tiles an
+// entry on average; past that, paths are still cached but fewer of their
+// tiles can start a suffix hit.
+class PathCache {
+public:
+    struct Stats {
+        int hits = 0;          // exact start and goal match
+        int suffixHits = 0;    // start was on a cached path to the goal
+        int misses = 0;        // had to search
+        int evictions = 0;     // pushed out to stay within capacity
+        int invalidations = 0; // dropped because the map changed
+
+        float hitRate() const
+        {
+            int total = hits + suffixHits + misses;
+            return total > 0 ? (float)(hits + suffixHits) / total : 0.0f;
+        }
+    };
+
+    static const size_t TILES_PER_ENTRY = 32;
+
+    explicit PathCache(size_t capacity = 64);
+
+    // Same result as ::findPath(), served from the cache when possible.
+    // Modes other than isShortestTileMode() ones always search; entries are
+    // shortest tile-by-tile paths.
+    bool findPath(const Map& map, const Node& start, const Node& dest, SearchMode mode, TilePath& path);
+    std::vector<Node> findPath(const Map& map, const Node& start, const Node& dest, SearchMode mode);
+
+    void clear();
+
+    size_t size() const { return entries.size(); }
+    size_t getCapacity() const { return capacity; }
+
+    const Stats& getStats() const { return stats; }
+    void resetStats() { stats = Stats(); }
+
+private:
+    struct Entry {
+        unsigned long long key;
+        SearchMode mode;
+        std::vector<int> tiles;
+    };
+
+    typedef std::list<Entry>::iterator EntryIt;
+
+    // Where a tile sits on a cached path toward some goal
+    struct PathPosition {
+        EntryIt entry;
+        size_t index;
+    };
+
+    static unsigned long long makeKey(int startTile, int goalTile, SearchMode mode);
+
+    void insert(unsigned long long key, const TilePath& path, int goalTile, SearchMode mode);
+
+    // Remove an entry from the indexes; the list node stays for reuse
+    void unindex(EntryIt it);
+
+    size_t capacity;
+    unsigned int mapVersion = 0;
+
+    // most recently used at the front; spare holds the unused nodes
+    std::list<Entry> entries;
+    std::list<Entry> spare;
+    FlatMap<EntryIt> byKey;
+
+    // (tile, goal, mode) -> a cached path passing through tile
+    FlatMap<PathPosition> byTile;
+
+    Stats stats;
+};
@@ -0,0 +1,18 @@
+#include "Pathfinder.h"
+
+bool specializedAStar(const Map& theMap, const Node& start, const Node& dest, TilePath& path)
+{
+    if (theMap.getWidth() == Map::DEFAULT_WIDTH && theMap.getHeight() == Map::DEFAULT_HEIGHT) {
+        static thread_local LevelPathfinder level;
+        return level.findPath(theMap, start, dest, path);
+    }
+
+    static thread_local GridPathfinder grid;
+    return grid.findPath(theMap, start, dest, path);
+}
+
+bool octileAStar(const Map& theMap, const Node& start, const Node& dest, TilePath& path)
+{
+    static thread_local OctilePathfinder octile;
+    return octile.findPath(theMap, start, dest, path);
+}
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "BucketQueue.h"
+#include "IndexedHeap.h"
+#include "Map.h"
+#include "TilePath.h"
+
+// A* built from compile-time policies, so the compiler sees everything:
+//
+//   Pathfinder<Connectivity, Heuristic, CostT, Width, Height>
+//
+// - Connectivity: FourConnected or EightConnected. The neighbour loop runs
+//   a constant number of times and is unrolled.
+// - Heuristic: ManhattanHeuristic, OctileHeuristic or ZeroHeuristic.
+// - CostT: the g / f type, e.g. int32_t or float.
+// - Width, Height: the map size if it's known at compile time, so tile
+//   offsets and array sizes are constants. 0, 0 takes any size at runtime.
+//
+// Walkability is copied into a grid with a one-tile wall border, so
+// neighbours never need a bounds check. It's re-copied whenever the map's
+// version moves on. Paths come back as map tile indices like aStar()'s.
+// One instance per thread; it keeps its own scratch state.
+
+// Cost of a straight and a diagonal step. Integer costs are scaled by 10 so
+// a diagonal (14) stays close to sqrt(2) straight steps.
+template <typename CostT, bool Integral = std::is_integral<CostT>::value>
+struct MoveCosts {
+    static CostT straight() { return 10; }
+    static CostT diagonal() { return 14; }
+};
+
+template <typename CostT>
+struct MoveCosts<CostT, false> {
+    static CostT straight() { return 1; }
+    static CostT diagonal() { return (CostT)1.41421356; }
+};
+
+// up, right, down, left
+struct FourConnected {
+    static const int COUNT = 4;
+
+    static int dx(int k) { return k == 1 ? 1 : (k == 3 ? -1 : 0); }
+    static int dy(int k) { return k == 0 ? -1 : (k == 2 ? 1 : 0); }
+
+    template <typename CostT>
+    static CostT cost(int) { return MoveCosts<CostT>::straight(); }
+};
+
+// The four above, then up-right, down-right, down-left, up-left. A diagonal
+// step needs both tiles beside it open, so paths never cut wall corners.
+struct EightConnected {
+    static const int COUNT = 8;
+
+    static int dx(int k)
+    {
+        return k < 4 ? FourConnected::dx(k) : (k == 4 || k == 5 ? 1 : -1);
+    }
+
+    static int dy(int k)
+    {
+        return k < 4 ? FourConnected::dy(k) : (k == 4 || k == 7 ? -1 : 1);
+    }
+
+    template <typename CostT>
+    static CostT cost(int k)
+    {
+        return k < 4 ? MoveCosts<CostT>::straight() : MoveCosts<CostT>::diagonal();
+    }
+};
+
+// Exact with FourConnected; overestimates diagonals, so not for EightConnected
+struct ManhattanHeuristic {
+    template <typename CostT>
+    static CostT estimate(int dx, int dy)
+    {
+        return (CostT)(dx + dy) * MoveCosts<CostT>::straight();
+    }
+};
+
+// Exact on an open EightConnected grid
+struct OctileHeuristic {
+    template <typename CostT>
+    static CostT estimate(int dx, int dy)
+    {
+        const int diagonal = dx < dy ? dx : dy;
+        const int straight = (dx < dy ? dy : dx) - diagonal;
+        return (CostT)straight * MoveCosts<CostT>::straight() + (CostT)diagonal * MoveCosts<CostT>::diagonal();
+    }
+};
+
+// Dijkstra
+struct ZeroHeuristic {
+    template <typename CostT>
+    static CostT estimate(int, int) { return 0; }
+};
+
+// Open list for floating point costs: a heap, ties broken on h
+template <typename CostT, bool Integral = std::is_integral<CostT>::value>
+class PathfinderOpenList {
+public:
+    void reset(int tileCount) { heap.reset(tileCount); }
+    bool empty() const { return heap.empty(); }
+    void push(int tile, CostT f, CostT h) { heap.push(tile, (float)f, (float)h); }
+    int pop() { return heap.pop(); }
+
+private:
+    IndexedHeap heap;
+};
+
+// Integer costs: a BucketQueue. With a consistent heuristic a key is never
+// more than two steps' cost above the key it was pushed from.
+template <typename CostT>
+class PathfinderOpenList<CostT, true> {
+public:
+    void reset(int) { buckets.reset(2 * MoveCosts<CostT>::diagonal() + 1); }
+    bool empty() const { return buckets.empty(); }
+    void push(int tile, CostT f, CostT) { buckets.push(tile, (int)f); }
+    int pop() { return buckets.pop(); }
+
+private:
+    BucketQueue buckets;
+};
+
+// Per-tile arrays over the bordered grid: fixed-size arrays when the map
+// size is a template argument...
+template <typename CostT, int Width, int Height>
+class PathfinderGrid {
+public:
+    static const int STRIDE = Width + 2;
+    static const int COUNT = (Width + 2) * (Height + 2);
+
+    int stride() const { return STRIDE; }
+    int count() const { return COUNT; }
+
+    // Only a map of exactly this size can be searched
+    bool fits(int width, int height) { return width == Width && height == Height; }
+
+    std::array<uint8_t, COUNT> open{};
+    std::array<int32_t, COUNT> parent{};
+    std::array<CostT, COUNT> gCost{};
+    std::array<uint32_t, COUNT> stamp{};
+};
+
+// ...and vectors sized from the map otherwise
+template <typename CostT>
+class PathfinderGrid<CostT, 0, 0> {
+public:
+    int stride() const { return gridStride; }
+    int count() const { return gridCount; }
+
+    bool fits(int width, int height)
+    {
+        if (width + 2 != gridStride || (width + 2) * (height + 2) != gridCount) {
+            gridStride = width + 2;
+            gridCount = (width + 2) * (height + 2);
+            open.assign(gridCount, 0);
+            parent.assign(gridCount, -1);
+            gCost.assign(gridCount, 0);
+            stamp.assign(gridCount, 0);
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> open;
+    std::vector<int32_t> parent;
+    std::vector<CostT> gCost;
+    std::vector<uint32_t> stamp;
+
+private:
+    int gridStride = 0;
+    int gridCount = 0;
+};
+
+template <typename Connectivity, typename Heuristic, typename CostT, int Width = 0, int Height = 0>
+class Pathfinder {
+public:
+    // Same contract as aStar(): false (and an empty path) if there's no
+    // route, or the map isn't Width x Height for a fixed-size pathfinder
+    bool findPath(const Map& map, const Node& start, const Node& dest, TilePath& path)
+    {
+        path.clear();
+        expansions = 0;
+
+        if (!grid.fits(map.getWidth(), map.getHeight())) return false;
+        if (map.isBlocked(dest.x, dest.y)) return false;
+        if (start.x == dest.x && start.y == dest.y) return false;
+        if (isUnreachable(map, start, dest)) return false;
+
+        sync(map);
+        begin();
+
+        const int stride = grid.stride();
+        const int startTile = (start.y + 1) * stride + start.x + 1;
+        const int destTile = (dest.y + 1) * stride + dest.x + 1;
+
+        setNode(startTile, 0, startTile);
+        const CostT hStart = estimate(startTile, dest);
+        openList.push(startTile, hStart, hStart);
+
+        while (!openList.empty()) {
+            const int tile = openList.pop();
+
+            // a bucket queue leaves older entries behind when a tile improves
+            if (grid.stamp[tile] == generation + 1) continue;
+
+            grid.stamp[tile] = generation + 1;
+            expansions++;
+
+            if (tile == destTile) {
+                makePath(destTile, map.getWidth(), path);
+                return true;
+            }
+
+            for (int k = 0; k < Connectivity::COUNT; k++) {
+                const int dx = Connectivity::dx(k);
+                const int dy = Connectivity::dy(k);
+                const int next = tile + dy * stride + dx;
+
+                // the border is wall, so this also stops at the map edge
+                if (!grid.open[next]) continue;
+                if (dx != 0 && dy != 0 && !(grid.open[tile + dx] && grid.open[tile + dy * stride])) continue;
+                if (grid.stamp[next] == generation + 1) continue;
+
+                const CostT gNew = grid.gCost[tile] + Connectivity::template cost<CostT>(k);
+
+                if (grid.stamp[next] != generation || grid.gCost[next] > gNew) {
+                    const CostT hNew = estimate(next, dest);
+
+                    setNode(next, gNew, tile);
+                    openList.push(next, gNew + hNew, hNew);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Cost of the last path found, in MoveCosts units
+    CostT getLastCost() const { return lastCost; }
+
+    // Tiles closed by the last search
+    int getExpansions() const { return expansions; }
+
+private:
+    // Copy walkability in if the map changed since last time
+    void sync(const Map& map)
+    {
+        if (&map == syncedMap && map.getVersion() == syncedVersion) return;
+
+        const int stride = grid.stride();
+        for (int i = 0; i < grid.count(); i++) {
+            const int x = i % stride - 1;
+            const int y = i / stride - 1;
+            grid.open[i] = map.inBounds(x, y) && !map.isBlocked(x, y);
+        }
+
+        syncedMap = &map;
+        syncedVersion = map.getVersion();
+    }
+
+    // Two stamps per search, open and closed, as in SearchContext
+    void begin()
+    {
+        generation += 2;
+        if (generation == 0) {
+            for (int i = 0; i < grid.count(); i++) grid.stamp[i] = 0;
+            generation = 2;
+        }
+        openList.reset(grid.count());
+    }
+
+    void setNode(int tile, CostT cost, int parentTile)
+    {
+        grid.gCost[tile] = cost;
+        grid.parent[tile] = parentTile;
+        grid.stamp[tile] = generation;
+    }
+
+    CostT estimate(int tile, const Node& dest) const
+    {
+        const int dx = tile % grid.stride() - 1 - dest.x;
+        const int dy = tile / grid.stride() - 1 - dest.y;
+        return Heuristic::template estimate<CostT>(dx < 0 ? -dx : dx, dy < 0 ? -dy : dy);
+    }
+
+    // Parents back from destTile, converted to map tile indices. Steps can
+    // cost different amounts, so count them first and fill from the back.
+    void makePath(int destTile, int width, TilePath& path)
+    {
+        int length = 1;
+        for (int tile = destTile; grid.parent[tile] != tile; tile = grid.parent[tile]) {
+            length++;
+        }
+
+        path.reset(width, length);
+        lastCost = grid.gCost[destTile];
+
+        const int stride = grid.stride();
+        int tile = destTile;
+        for (int i = length - 1; i >= 0; i--) {
+            path.set(i, (tile / stride - 1) * width + tile % stride - 1);
+            tile = grid.parent[tile];
+        }
+    }
+
+    PathfinderGrid<CostT, Width, Height> grid;
+    PathfinderOpenList<CostT> openList;
+
+    const Map* syncedMap = nullptr;
+    unsigned int syncedVersion = 0;
+    uint32_t generation = 0;
+
+    CostT lastCost = 0;
+    int expansions = 0;
+};
+
+// 4-connected integer A*, fully specialised for the built-in 32x24 level
+typedef Pathfinder<FourConnected, ManhattanHeuristic, int32_t, Map::DEFAULT_WIDTH, Map::DEFAULT_HEIGHT> LevelPathfinder;
+
+// The same for maps of any size
+typedef Pathfinder<FourConnected, ManhattanHeuristic, int32_t> GridPathfinder;
+
+// Shortest path through whichever of the two fits the map, one per thread.
+// Same result as aStar() without landmark tables.
+bool specializedAStar(const Map& theMap, const Node& start, const Node& dest, TilePath& path);
+
+// 8-connected integer A*: diagonal steps cost 14 to a straight step's 10
+typedef Pathfinder<EightConnected, OctileHeuristic, int32_t> OctilePathfinder;
+
+// Shortest 8-connected path, one pathfinder per thread. Diagonal steps
+// never cut a wall corner, and the path still runs tile by tile.
+bool octileAStar(const Map& theMap, const Node& start, const Node& dest, TilePath& path);
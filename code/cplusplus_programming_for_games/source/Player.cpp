@@ -1,5 +1,6 @@
 #include "Player.h"
 #include <cmath>
+#include <cstdlib>
 
 void Player::update(float dt)
 {
@@ -11,21 +12,21 @@ void Player::update(float dt)
         Node start{ playerTileX, playerTileY };
         Node dest{ selectionTileX, selectionTileY };
 
-        path = aStar(*map, start, dest);
+        if (pathCache) pathCache->findPath(*map, start, dest, searchMode, path);
+        else findPath(*map, start, dest, searchMode, path);
         runAstar = false;
 
-        // If the path includes the current tile first, remove it
-        if (!path.empty() && path.front().x == playerTileX && path.front().y == playerTileY) {
-            path.erase(path.begin());
-        }
+        // If the path includes the current tile first, skip it
+        path.skipIfAt(playerTileX, playerTileY);
     }
 
     if (path.empty()) return;
 
     // Move toward next tile center
-    const Node next = path.front();
-    const float targetX = next.x * TILE_SIZE + TILE_SIZE * 0.5f;
-    const float targetY = next.y * TILE_SIZE + TILE_SIZE * 0.5f;
+    const int nextX = path.frontX();
+    const int nextY = path.frontY();
+    const float targetX = nextX * TILE_SIZE + TILE_SIZE * 0.5f;
+    const float targetY = nextY * TILE_SIZE + TILE_SIZE * 0.5f;
 
     const float dx = targetX - px;
     const float dy = targetY - py;
@@ -36,10 +37,10 @@ void Player::update(float dt)
         px = targetX;
         py = targetY;
 
-        playerTileX = next.x;
-        playerTileY = next.y;
+        playerTileX = nextX;
+        playerTileY = nextY;
 
-        path.erase(path.begin());
+        path.advance();
         return;
     }
 
@@ -50,14 +51,21 @@ void Player::update(float dt)
         px = targetX;
         py = targetY;
 
-        playerTileX = next.x;
-        playerTileY = next.y;
+        playerTileX = nextX;
+        playerTileY = nextY;
 
-        path.erase(path.begin());
+        path.advance();
     }
     else {
         px += (dx / dist) * step;
         py += (dy / dist) * step;
+
+        // Partway along a straight run to a tile further than a step away:
+        // a new path should start where we are, not where the run began
+        if (std::abs(nextX - playerTileX) > 1 || std::abs(nextY - playerTileY) > 1) {
+            playerTileX = (int)px / TILE_SIZE;
+            playerTileY = (int)py / TILE_SIZE;
+        }
     }
 }
 
@@ -6,6 +6,7 @@
 
 #include "AStarSearch.h"
 #include "Map.h"
+#include "PathCache.h"
 
 class Player {
 public:
@@ -61,10 +62,10 @@ public:
         }
 
         // draw path tiles
-        for (const Node& n : path) {
+        for (int i = 0; i < path.size(); i++) {
             SDL_Rect d = {
-                n.x * TILE_SIZE - camX,
-                n.y * TILE_SIZE - camY,
+                path.xAt(i) * TILE_SIZE - camX,
+                path.yAt(i) * TILE_SIZE - camY,
                 TILE_SIZE, TILE_SIZE
             };
             SDL_RenderCopy(renderer, pathSelected, nullptr, &d);
@@ -93,6 +94,11 @@ public:
     int getCenterX() const { return (int)px; }
     int getCenterY() const { return (int)py; }
 
+    void setSearchMode(SearchMode mode) { searchMode = mode; }
+
+    // Look clicked destinations up in a shared cache before searching
+    void setPathCache(PathCache* cache) { pathCache = cache; }
+
 private:
     SDL_Renderer* renderer = nullptr;
     SDL_Texture* player = nullptr;
@@ -116,6 +122,8 @@ private:
     // tweak this to control speed (pixels per second)
     float moveSpeed = 220.0f;
 
-    std::vector<Node> path;
+    TilePath path;
     bool runAstar = false;
+    SearchMode searchMode = SearchMode::AStar;
+    PathCache* pathCache = nullptr;
 };
\ No newline at end of file
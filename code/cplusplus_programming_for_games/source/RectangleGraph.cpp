@@ -0,0 +1,298 @@
+#include "RectangleGraph.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// up, right, down, left
+static const int DIR_X[4] = { 0, 1, 0, -1 };
+static const int DIR_Y[4] = { -1, 0, 1, 0 };
+
+const int RectangleGraph::BLOCKED;
+const int RectangleGraph::UNASSIGNED;
+
+static thread_local SearchContext defaultContext;
+
+bool RectangleGraph::columnsFree(int x, int y, int w) const
+{
+    const int* row = &rectId[y * width + x];
+    return std::find_if(row, row + w, [](int id) { return id != UNASSIGNED; }) == row + w;
+}
+
+bool RectangleGraph::rowsFree(int x, int y, int h) const
+{
+    for (int ty = y; ty < y + h; ty++) {
+        if (rectId[ty * width + x] != UNASSIGNED) return false;
+    }
+    return true;
+}
+
+void RectangleGraph::grow(int x, int y)
+{
+    // as wide as it goes, then as far down as that width allows...
+    int w = 1;
+    while (x + w < width && rectId[y * width + x + w] == UNASSIGNED) w++;
+
+    int h = 1;
+    while (y + h < height && columnsFree(x, y + h, w)) h++;
+
+    // ...or as tall as it goes, then as wide; whichever covers more
+    int tallH = 1;
+    while (y + tallH < height && rectId[(y + tallH) * width + x] == UNASSIGNED) tallH++;
+
+    int tallW = 1;
+    while (x + tallW < width && rowsFree(x + tallW, y, tallH)) tallW++;
+
+    if (tallW * tallH > w * h) {
+        w = tallW;
+        h = tallH;
+    }
+
+    int id = (int)rects.size();
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    else {
+        rects.push_back(Rect());
+    }
+
+    Rect& r = rects[id];
+    r.x = x;
+    r.y = y;
+    r.w = w;
+    r.h = h;
+
+    for (int ty = y; ty < y + h; ty++) {
+        std::fill(&rectId[ty * width + x], &rectId[ty * width + x] + w, id);
+    }
+}
+
+void RectangleGraph::cover(int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            if (rectId[y * width + x] == UNASSIGNED) grow(x, y);
+        }
+    }
+}
+
+void RectangleGraph::build(const Map& map)
+{
+    walk = map.getWalkBits();
+    version = map.getVersion();
+    width = map.getWidth();
+    height = map.getHeight();
+
+    rects.clear();
+    freeIds.clear();
+    rectId.assign(width * height, BLOCKED);
+
+    for (int t = 0; t < width * height; t++) {
+        if (walk.get(t % width, t / width)) rectId[t] = UNASSIGNED;
+    }
+    cover(0, 0, width - 1, height - 1);
+}
+
+void RectangleGraph::update(const Map& map)
+{
+    if (rectId.empty() || map.getVersion() == version) return;
+
+    std::vector<int> changed;
+    if (!map.getChangesSince(version, changed) || map.getWidth() != width || map.getHeight() != height) {
+        build(map);
+        return;
+    }
+
+    for (int tile : changed) {
+        const int x = tile % width;
+        const int y = tile / width;
+
+        const bool open = !map.isBlocked(x, y);
+        if (open == walk.get(x, y)) continue;
+
+        // a wall appearing would split a rectangle
+        if (!open) {
+            build(map);
+            return;
+        }
+        walk.set(x, y, true);
+
+        // Take apart the new tile's neighbouring rectangles and cut the
+        // area up again with it included
+        int x0 = x, y0 = y, x1 = x, y1 = y;
+        rectId[tile] = UNASSIGNED;
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+            const int id = rectId[ny * width + nx];
+            if (id < 0) continue;
+
+            const Rect r = rects[id];
+            for (int ty = r.y; ty < r.y + r.h; ty++) {
+                std::fill(&rectId[ty * width + r.x], &rectId[ty * width + r.x] + r.w, UNASSIGNED);
+            }
+            freeIds.push_back(id);
+
+            x0 = std::min(x0, r.x);
+            y0 = std::min(y0, r.y);
+            x1 = std::max(x1, r.x + r.w - 1);
+            y1 = std::max(y1, r.y + r.h - 1);
+        }
+
+        cover(x0, y0, x1, y1);
+    }
+
+    version = map.getVersion();
+}
+
+int RectangleGraph::getPerimeterTileCount() const
+{
+    int count = 0;
+    for (int id = 0; id < (int)rects.size(); id++) {
+        if (std::find(freeIds.begin(), freeIds.end(), id) != freeIds.end()) continue;
+
+        const Rect& r = rects[id];
+        count += r.w * r.h - std::max(r.w - 2, 0) * std::max(r.h - 2, 0);
+    }
+    return count;
+}
+
+void RectangleGraph::relax(int from, int fromX, int fromY, int toX, int toY, const Node& dest, SearchContext& context) const
+{
+    const int to = toY * width + toX;
+    if (context.isClosed(to)) return;
+
+    const int32_t gNew = context.getG(from) + abs(toX - fromX) + abs(toY - fromY);
+
+    if (!context.isSeen(to) || context.getG(to) > gNew) {
+        const float hNew = (float)(abs(toX - dest.x) + abs(toY - dest.y));
+        context.setNode(to, gNew, from);
+        context.openList.push(to, gNew + hNew, hNew);
+    }
+}
+
+void RectangleGraph::expand(int tile, const Node& dest, SearchContext& context) const
+{
+    const int x = tile % width;
+    const int y = tile / width;
+    const int id = rectId[tile];
+
+    // a blocked start (standing in a new wall) just steps out
+    if (id < 0) {
+        for (int d = 0; d < 4; d++) {
+            const int nx = x + DIR_X[d];
+            const int ny = y + DIR_Y[d];
+            if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+            if (rectId[ny * width + nx] >= 0) relax(tile, x, y, nx, ny, dest, context);
+        }
+        return;
+    }
+
+    const Rect& r = rects[id];
+    const int left = r.x;
+    const int right = r.x + r.w - 1;
+    const int top = r.y;
+    const int bottom = r.y + r.h - 1;
+
+    // Only the start is ever inside; it heads straight for each side
+    if (r.interior(x, y)) {
+        relax(tile, x, y, left, y, dest, context);
+        relax(tile, x, y, right, y, dest, context);
+        relax(tile, x, y, x, top, dest, context);
+        relax(tile, x, y, x, bottom, dest, context);
+        return;
+    }
+
+    // steps along the perimeter and out of the rectangle
+    for (int d = 0; d < 4; d++) {
+        const int nx = x + DIR_X[d];
+        const int ny = y + DIR_Y[d];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+        const int next = ny * width + nx;
+        if (rectId[next] < 0) continue;
+        if (rectId[next] == id && r.interior(nx, ny)) continue;
+
+        relax(tile, x, y, nx, ny, dest, context);
+    }
+
+    // straight across to the opposite side
+    if (r.w > 2) {
+        if (x == left) relax(tile, x, y, right, y, dest, context);
+        else if (x == right) relax(tile, x, y, left, y, dest, context);
+    }
+    if (r.h > 2) {
+        if (y == top) relax(tile, x, y, x, bottom, dest, context);
+        else if (y == bottom) relax(tile, x, y, x, top, dest, context);
+    }
+
+    // straight in to a dest inside this rectangle
+    if ((dest.x == x || dest.y == y) && r.interior(dest.x, dest.y)) {
+        relax(tile, x, y, dest.x, dest.y, dest, context);
+    }
+}
+
+bool RectangleGraph::findPath(const Map& map, const Node& start, const Node& dest, SearchContext& context, TilePath& path) const
+{
+    path.clear();
+
+    if (map.isBlocked(dest.x, dest.y)) return false;
+    if (start.x == dest.x && start.y == dest.y) return false;
+    if (isUnreachable(map, start, dest)) return false;
+
+    const int startTile = start.y * width + start.x;
+    const int destTile = dest.y * width + dest.x;
+
+    // Both in one rectangle: across, then up or down, is already shortest
+    if (rectId[startTile] >= 0 && rectId[startTile] == rectId[destTile]) {
+        const int length = abs(start.x - dest.x) + abs(start.y - dest.y);
+        path.reset(width, length + 1);
+
+        int x = start.x;
+        int y = start.y;
+        for (int i = 0; i <= length; i++) {
+            path.set(i, y * width + x);
+            if (x != dest.x) x += x < dest.x ? 1 : -1;
+            else y += y < dest.y ? 1 : -1;
+        }
+        return true;
+    }
+
+    context.begin(width, height);
+    context.setNode(startTile, 0, startTile);
+    const float hStart = (float)(abs(start.x - dest.x) + abs(start.y - dest.y));
+    context.openList.push(startTile, hStart, hStart);
+
+    while (!context.openList.empty()) {
+        const int tile = context.openList.pop();
+        context.close(tile);
+
+        if (tile == destTile) {
+            // every jump is along a straight line, which makePath() fills in
+            makePath(context, destTile, path);
+            return true;
+        }
+
+        expand(tile, dest, context);
+    }
+    return false;
+}
+
+std::vector<Node> RectangleGraph::findPath(const Map& map, const Node& start, const Node& dest) const
+{
+    TilePath path;
+    findPath(map, start, dest, defaultContext, path);
+    return toNodes(path);
+}
+
+bool rectangleSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path)
+{
+    const RectangleGraph* graph = theMap.getRectangles();
+    if (!graph || !graph->isCurrent(theMap)) return aStar(theMap, start, dest, context, path);
+
+    return graph->findPath(theMap, start, dest, context, path);
+}
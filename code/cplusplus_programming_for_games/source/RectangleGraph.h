@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Map.h"
+#include "SearchContext.h"
+#include "TilePath.h"
+#include "WalkBits.h"
+
+// Rectangular symmetry reduction. The open tiles are cut into empty
+// rectangles, each grown greedily as far as it will go one way and then the
+// other, keeping the bigger of the two shapes. Every
+// shortest path through a rectangle can be swapped for one that only runs
+// along its edges and straight across it, so the search:
+//
+// - never steps from a perimeter tile into the interior,
+// - instead jumps straight across to the opposite side (a macro edge
+//   costing the rectangle's width or height less one),
+// - leaves an interior start straight toward each side, and reaches an
+//   interior dest straight from the perimeter tiles in its row or column.
+//
+// An open room then costs its perimeter, not its area. Paths are the same
+// length as aStar()'s and come out tile by tile.
+//
+// Attach it with Map::setRectangles(); SearchMode::Rectangles then uses it.
+// Breaking a tile merges it with the rectangles beside it and cuts just
+// that area up again.
+class RectangleGraph {
+public:
+    // Full rebuild for the current map
+    void build(const Map& map);
+
+    // Catch up with tiles changed since the last build or update
+    void update(const Map& map);
+
+    // Rectangles describe the map as it is now
+    bool isCurrent(const Map& map) const
+    {
+        return !rectId.empty() && version == map.getVersion();
+    }
+
+    // Same contract as aStar(): a shortest tile-by-tile path, or false (and
+    // an empty path) if there is none
+    bool findPath(const Map& map, const Node& start, const Node& dest, SearchContext& context, TilePath& path) const;
+    std::vector<Node> findPath(const Map& map, const Node& start, const Node& dest) const;
+
+    int getRectangleCount() const { return (int)rects.size() - (int)freeIds.size(); }
+
+    // Tiles the search can still stop on
+    int getPerimeterTileCount() const;
+
+private:
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int w = 0;
+        int h = 0;
+
+        bool interior(int tx, int ty) const
+        {
+            return tx > x && tx < x + w - 1 && ty > y && ty < y + h - 1;
+        }
+    };
+
+    // rectId values for tiles in no rectangle
+    static const int BLOCKED = -1;
+    static const int UNASSIGNED = -2;
+
+    // Grow a rectangle from (x, y) over UNASSIGNED tiles: right then down,
+    // or down then right if that's bigger
+    void grow(int x, int y);
+
+    // w tiles of row y from x are all UNASSIGNED
+    bool columnsFree(int x, int y, int w) const;
+
+    // h tiles of column x from y are all UNASSIGNED
+    bool rowsFree(int x, int y, int h) const;
+
+    // Cover every UNASSIGNED tile in the box with rectangles
+    void cover(int x0, int y0, int x1, int y1);
+
+    // Offer the moves out of a closed tile
+    void expand(int tile, const Node& dest, SearchContext& context) const;
+
+    // Offer (toX, toY) a route straight from the closed tile at (fromX, fromY)
+    void relax(int from, int fromX, int fromY, int toX, int toY, const Node& dest, SearchContext& context) const;
+
+    WalkBits walk;
+    unsigned int version = 0;
+    int width = 0;
+    int height = 0;
+
+    // rectangle of each tile, or BLOCKED
+    std::vector<int> rectId;
+    std::vector<Rect> rects;
+
+    // ids of rectangles merged away, for reuse
+    std::vector<int> freeIds;
+};
+
+// Shortest path through the map's rectangles (Map::setRectangles), or
+// aStar() if it has none that are current
+bool rectangleSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path);
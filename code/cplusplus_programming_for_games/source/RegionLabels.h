@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "WalkBits.h"
+
+// Connected regions of walkable tiles (4-connected), as a union-find forest.
+// Two tiles have the same region() exactly when a path exists between them,
+// so a pathfinder can turn down a sealed-off goal without searching.
+// Opening a tile only ever merges regions, which union-find does in place.
+class RegionLabels {
+public:
+    // Label every walkable tile from scratch
+    void build(const WalkBits& walk)
+    {
+        width = walk.getWidth();
+        height = walk.getHeight();
+        parent.assign(width * height, -1);
+        size.assign(width * height, 0);
+        regionCount = 0;
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (!walk.get(x, y)) continue;
+
+                int tile = y * width + x;
+                addTile(tile);
+                if (x > 0 && walk.get(x - 1, y)) merge(tile, tile - 1);
+                if (y > 0 && walk.get(x, y - 1)) merge(tile, tile - width);
+            }
+        }
+
+        // flatten so every lookup is a single step until the next merge
+        for (int i = 0; i < width * height; i++) {
+            if (parent[i] != -1) parent[i] = root(i);
+        }
+    }
+
+    // A tile became walkable: give it a region and join it to its neighbours
+    void open(const WalkBits& walk, int x, int y)
+    {
+        int tile = y * width + x;
+        if (parent[tile] != -1) return;
+
+        addTile(tile);
+        if (x > 0 && walk.get(x - 1, y)) merge(tile, tile - 1);
+        if (y > 0 && walk.get(x, y - 1)) merge(tile, tile - width);
+        if (x + 1 < width && walk.get(x + 1, y)) merge(tile, tile + 1);
+        if (y + 1 < height && walk.get(x, y + 1)) merge(tile, tile + width);
+    }
+
+    // Region id of a tile, or -1 if it is blocked.
+    // Does not modify the forest, so it is safe to call from several threads.
+    int region(int tile) const
+    {
+        if (parent[tile] == -1) return -1;
+        return root(tile);
+    }
+
+    int getRegionCount() const { return regionCount; }
+
+private:
+    void addTile(int tile)
+    {
+        parent[tile] = tile;
+        size[tile] = 1;
+        regionCount++;
+    }
+
+    // Union by size keeps every tree O(log n) deep without compressing in find
+    int root(int tile) const
+    {
+        while (parent[tile] != tile) tile = parent[tile];
+        return tile;
+    }
+
+    void merge(int a, int b)
+    {
+        a = root(a);
+        b = root(b);
+        if (a == b) return;
+
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        regionCount--;
+    }
+
+    int width = 0;
+    int height = 0;
+    int regionCount = 0;
+    std::vector<int> parent;
+    std::vector<int> size;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Space-time reservations: which agent will stand on a tile at a given tick.
+// A flat open-addressing hash map keyed on (tile, tick), so lookups are a
+// multiply and a short probe rather than a node allocation per entry.
+// clear() is O(1): entries from older rounds are told apart by a stamp.
+// Most tiles are never reserved at all, so a per-tile stamp answers those
+// lookups without touching the hash.
+class ReservationTable {
+public:
+    ReservationTable()
+    {
+        slots.resize((size_t)1 << bits);
+    }
+
+    void clear()
+    {
+        generation++;
+        count = 0;
+
+        if (generation == 0) {
+            // wrapped around; old stamps could now look current
+            for (Slot& s : slots) s.stamp = 0;
+            tileStamp.assign(tileStamp.size(), 0);
+            generation = 1;
+        }
+    }
+
+    // Claim (tile, tick) for agent. False, and the claim left as it was, if
+    // another agent already holds it.
+    bool reserve(int tile, int tick, int agent)
+    {
+        if ((count + 1) * 2 > slots.size()) grow();
+
+        const uint64_t key = makeKey(tile, tick);
+        size_t i = slotFor(key);
+
+        while (slots[i].stamp == generation && slots[i].key != key) {
+            i = (i + 1) & (slots.size() - 1);
+        }
+
+        if (slots[i].stamp == generation) {
+            if (slots[i].agent != agent) return false;
+        }
+        else {
+            count++;
+        }
+        slots[i].key = key;
+        slots[i].agent = agent;
+        slots[i].stamp = generation;
+
+        if (tile >= (int)tileStamp.size()) tileStamp.resize(tile + 1, 0);
+        tileStamp[tile] = generation;
+        return true;
+    }
+
+    // Agent holding (tile, tick), or -1 if it is free
+    int reservedBy(int tile, int tick) const
+    {
+        if (tile >= (int)tileStamp.size() || tileStamp[tile] != generation) return -1;
+
+        const uint64_t key = makeKey(tile, tick);
+        size_t i = slotFor(key);
+
+        while (slots[i].stamp == generation) {
+            if (slots[i].key == key) return slots[i].agent;
+            i = (i + 1) & (slots.size() - 1);
+        }
+        return -1;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        int agent = -1;
+        uint32_t stamp = 0;
+    };
+
+    static uint64_t makeKey(int tile, int tick)
+    {
+        return ((uint64_t)(uint32_t)tick << 32) | (uint32_t)tile;
+    }
+
+    // Fibonacci hashing: the top bits of the product pick the slot
+    size_t slotFor(uint64_t key) const
+    {
+        return (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
+
+    void grow()
+    {
+        std::vector<Slot> old;
+        old.swap(slots);
+        bits++;
+        slots.resize((size_t)1 << bits);
+        count = 0;
+
+        for (const Slot& s : old) {
+            if (s.stamp == generation) {
+                reserve((int)(uint32_t)s.key, (int)(s.key >> 32), s.agent);
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> tileStamp;
+    int bits = 10;
+    size_t count = 0;
+    uint32_t generation = 1;
+};
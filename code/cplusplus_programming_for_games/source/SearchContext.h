@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BucketQueue.h"
+#include "IndexedHeap.h"
+
+// Scratch state for one grid search, owned by whoever runs the search.
+// Give each thread its own context and searches never share memory.
+//
+// Per-tile data is kept as separate arrays (structure of arrays): the parent
+// tile index, the g-cost, and a stamp recording which search last touched
+// the tile. begin() just moves the stamp on, so a tile whose stamp is old
+// counts as unvisited. Starting a search costs O(1) however large the map is.
+class SearchContext {
+public:
+    // Start a new search on a width x height grid
+    void begin(int width, int height)
+    {
+        const size_t count = (size_t)width * height;
+
+        if (stamp.size() != count) {
+            parent.assign(count, -1);
+            gCost.assign(count, 0);
+            stamp.assign(count, 0);
+            generation = 0;
+        }
+
+        // two stamps per search: open and closed
+        generation += 2;
+        if (generation == 0) {
+            // wrapped around; old stamps could now look current
+            stamp.assign(count, 0);
+            generation = 2;
+        }
+
+        gridWidth = width;
+        openList.reset((int)count);
+        expansions = 0;
+    }
+
+    bool isSeen(int tile) const { return stamp[tile] >= generation; }
+    bool isClosed(int tile) const { return stamp[tile] == generation + 1; }
+
+    // Record a (better) route into tile; marks it seen and open
+    void setNode(int tile, int32_t cost, int32_t parentTile)
+    {
+        gCost[tile] = cost;
+        parent[tile] = parentTile;
+        stamp[tile] = generation;
+    }
+
+    void close(int tile)
+    {
+        stamp[tile] = generation + 1;
+        expansions++;
+    }
+
+    int32_t getG(int tile) const { return gCost[tile]; }
+    int32_t getParent(int tile) const { return parent[tile]; }
+
+    int getWidth() const { return gridWidth; }
+
+    // Tiles closed since begin()
+    int getExpansions() const { return expansions; }
+
+    IndexedHeap openList;
+
+    // open list for integer-cost searches (dialSearch())
+    BucketQueue buckets;
+
+private:
+    std::vector<int32_t> parent;
+    std::vector<int32_t> gCost;
+    std::vector<uint32_t> stamp;
+
+    uint32_t generation = 0;
+    int gridWidth = 0;
+    int expansions = 0;
+};
@@ -0,0 +1,343 @@
+#include "SubgoalGraph.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// sweep() tile states
+static const uint8_t UNREACHED = 0;
+static const uint8_t REACHED = 1;
+static const uint8_t STOPPED = 2;
+
+// scratch for queries, one per thread
+static thread_local SearchContext defaultContext;
+static thread_local std::vector<uint8_t> sweepState;
+static thread_local std::vector<int> startLinks;
+static thread_local std::vector<int> destLinks;
+static thread_local std::vector<int> waypoints;
+
+static int manhattan(int a, int b, int width)
+{
+    return abs(a % width - b % width) + abs(a / width - b / width);
+}
+
+bool SubgoalGraph::cornerAt(int x, int y) const
+{
+    static const int DIAG_X[4] = { 1, 1, -1, -1 };
+    static const int DIAG_Y[4] = { -1, 1, 1, -1 };
+
+    for (int d = 0; d < 4; d++) {
+        const int dx = DIAG_X[d];
+        const int dy = DIAG_Y[d];
+        if (!open(x + dx, y + dy) && open(x + dx, y) && open(x, y + dy)) return true;
+    }
+    return false;
+}
+
+void SubgoalGraph::sweep(int ox, int oy, int qx, int qy, int endX, int endY, bool stopAtSubgoals, int stopTile,
+    std::vector<uint8_t>& state, std::vector<int>* found) const
+{
+    const int cols = (endX - ox) * qx + 1;
+    const int rows = (endY - oy) * qy + 1;
+
+    // Only grows; nothing is cleared up front. Each row writes every tile
+    // from lo - 1 to where it stops, and that's all anything reads back, so
+    // a sweep costs the tiles it reaches rather than the whole quadrant.
+    if (state.size() < (size_t)cols * rows) state.resize((size_t)cols * rows);
+
+    // Every tile is entered from the one before it in its row or the one
+    // above it. [lo, hi] spans the tiles of the row above that carry on, so
+    // nothing left of lo is reachable and nothing right of hi is unless the
+    // row itself runs on.
+    int lo = 0;
+    int hi = 0;
+
+    for (int r = 0; r < rows; r++) {
+        const int y = oy + r * qy;
+        uint8_t* row = &state[(size_t)r * cols];
+        const uint8_t* above = r > 0 ? row - cols : nullptr;
+
+        if (lo > 0) row[lo - 1] = UNREACHED;
+
+        int nextLo = -1;
+        int nextHi = -1;
+
+        for (int c = lo; c < cols; c++) {
+            const bool fromLeft = c > 0 && row[c - 1] == REACHED;
+            const bool fromAbove = r == 0 ? c == 0 : (c <= hi && above[c] == REACHED);
+            const int x = ox + c * qx;
+
+            // the origin may be blocked (standing in a new wall)
+            const bool entered = (r == 0 && c == 0) || ((fromLeft || fromAbove) && walk.get(x, y));
+            if (!entered) {
+                row[c] = UNREACHED;
+                if (c >= hi) break;
+                continue;
+            }
+
+            const int tile = y * width + x;
+            const bool stop = (r > 0 || c > 0) && (isSubgoal[tile] || tile == stopTile);
+
+            if (stop && found) found->push_back(tile);
+
+            if (stop && stopAtSubgoals) {
+                row[c] = STOPPED;
+                continue;
+            }
+
+            row[c] = REACHED;
+            if (nextLo == -1) nextLo = c;
+            nextHi = c;
+        }
+
+        if (nextLo == -1) break;
+        lo = nextLo;
+        hi = nextHi;
+    }
+}
+
+void SubgoalGraph::directlyReachable(int tile, int destTile, std::vector<uint8_t>& state, std::vector<int>& out) const
+{
+    out.clear();
+
+    const int x = tile % width;
+    const int y = tile / width;
+
+    for (int qy = -1; qy <= 1; qy += 2) {
+        for (int qx = -1; qx <= 1; qx += 2) {
+            sweep(x, y, qx, qy, qx > 0 ? width - 1 : 0, qy > 0 ? height - 1 : 0, true, destTile, state, &out);
+        }
+    }
+
+    // tiles straight along an axis are in two quadrants
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void SubgoalGraph::writeLeg(int from, int to, int first, std::vector<uint8_t>& state, TilePath& path) const
+{
+    const int fx = from % width;
+    const int fy = from / width;
+    const int tx = to % width;
+    const int ty = to / width;
+    const int qx = tx >= fx ? 1 : -1;
+    const int qy = ty >= fy ? 1 : -1;
+
+    sweep(fx, fy, qx, qy, tx, ty, false, -1, state, nullptr);
+
+    // back from the far corner, left where the row came from there, else up
+    const int cols = (tx - fx) * qx + 1;
+    int c = cols - 1;
+    int r = (ty - fy) * qy;
+    int i = first + c + r;
+
+    while (r > 0 || c > 0) {
+        path.set(i--, (fy + r * qy) * width + fx + c * qx);
+
+        if (c > 0 && state[(size_t)r * cols + c - 1] == REACHED) c--;
+        else r--;
+    }
+}
+
+void SubgoalGraph::build(const Map& map)
+{
+    walk = map.getWalkBits();
+    version = map.getVersion();
+    width = map.getWidth();
+    height = map.getHeight();
+
+    const int tileCount = width * height;
+
+    isSubgoal.clear();
+    edges.clear();
+
+    if (tileCount > MAX_TILES) return;
+
+    isSubgoal.assign(tileCount, 0);
+    edges.assign(tileCount, std::vector<int>());
+
+    for (int t = 0; t < tileCount; t++) {
+        const int x = t % width;
+        const int y = t / width;
+        isSubgoal[t] = open(x, y) && cornerAt(x, y);
+    }
+
+    std::vector<uint8_t> state;
+    for (int t = 0; t < tileCount; t++) {
+        if (isSubgoal[t]) directlyReachable(t, -1, state, edges[t]);
+    }
+}
+
+void SubgoalGraph::update(const Map& map)
+{
+    if (isSubgoal.empty() || map.getVersion() == version) return;
+
+    std::vector<int> changed;
+    if (!map.getChangesSince(version, changed) || map.getWidth() != width || map.getHeight() != height) {
+        build(map);
+        return;
+    }
+
+    std::vector<int> opened;
+    for (int tile : changed) {
+        const bool nowOpen = !map.isBlocked(tile % width, tile / width);
+        if (nowOpen == walk.get(tile % width, tile / width)) continue;
+
+        // a wall appearing can cut any link
+        if (!nowOpen) {
+            build(map);
+            return;
+        }
+        walk.set(tile % width, tile / width, true);
+        opened.push_back(tile);
+    }
+
+    std::vector<uint8_t> relink(width * height, 0);
+    std::vector<int> window;
+
+    // a tile is a corner because of the 3x3 around it, so corners can only
+    // come or go next to an opened tile
+    for (int tile : opened) {
+        const int x = tile % width;
+        const int y = tile / width;
+
+        for (int ny = y - 1; ny <= y + 1; ny++) {
+            for (int nx = x - 1; nx <= x + 1; nx++) {
+                if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+
+                const int t = ny * width + nx;
+                const bool was = isSubgoal[t] != 0;
+                const bool now = open(nx, ny) && cornerAt(nx, ny);
+
+                isSubgoal[t] = now;
+                if (was || now) relink[t] = 1;
+                if (was && !now) edges[t].clear();
+                if (open(nx, ny)) window.push_back(t);
+            }
+        }
+    }
+
+    // Any subgoal whose links could have changed has a straight-ahead path
+    // to one of those tiles, so a sweep back from each of them finds it.
+    // These sweeps run on past subgoals, so they can only find too many.
+    std::vector<uint8_t> state;
+    std::vector<int> seen;
+
+    for (int t : window) {
+        const int x = t % width;
+        const int y = t / width;
+
+        for (int qy = -1; qy <= 1; qy += 2) {
+            for (int qx = -1; qx <= 1; qx += 2) {
+                seen.clear();
+                sweep(x, y, qx, qy, qx > 0 ? width - 1 : 0, qy > 0 ? height - 1 : 0, false, -1, state, &seen);
+                for (int s : seen) relink[s] = 1;
+            }
+        }
+    }
+
+    for (int t = 0; t < width * height; t++) {
+        if (relink[t] && isSubgoal[t]) directlyReachable(t, -1, state, edges[t]);
+    }
+
+    version = map.getVersion();
+}
+
+bool SubgoalGraph::findPath(const Map& map, const Node& start, const Node& dest, SearchContext& context, TilePath& path) const
+{
+    path.clear();
+
+    if (map.isBlocked(dest.x, dest.y)) return false;
+    if (start.x == dest.x && start.y == dest.y) return false;
+    if (isUnreachable(map, start, dest)) return false;
+
+    const int startTile = start.y * width + start.x;
+    const int destTile = dest.y * width + dest.x;
+
+    // Link the ends in. The start's links include dest itself if a
+    // straight-ahead path reaches it.
+    directlyReachable(destTile, -1, sweepState, destLinks);
+    directlyReachable(startTile, destTile, sweepState, startLinks);
+
+    context.begin(width, height);
+    context.setNode(startTile, 0, startTile);
+    const float hStart = (float)manhattan(startTile, destTile, width);
+    context.openList.push(startTile, hStart, hStart);
+
+    bool found = false;
+
+    while (!context.openList.empty()) {
+        const int tile = context.openList.pop();
+        context.close(tile);
+
+        if (tile == destTile) {
+            found = true;
+            break;
+        }
+
+        const std::vector<int>& links = tile == startTile ? startLinks : edges[tile];
+        const bool linksDest = tile != startTile && std::binary_search(destLinks.begin(), destLinks.end(), tile);
+
+        for (size_t i = 0; i < links.size() + (linksDest ? 1 : 0); i++) {
+            const int next = i < links.size() ? links[i] : destTile;
+            if (context.isClosed(next)) continue;
+
+            const int32_t gNew = context.getG(tile) + manhattan(tile, next, width);
+            if (!context.isSeen(next) || context.getG(next) > gNew) {
+                const float hNew = (float)manhattan(next, destTile, width);
+                context.setNode(next, gNew, tile);
+                context.openList.push(next, gNew + hNew, hNew);
+            }
+        }
+    }
+
+    if (!found) return false;
+
+    waypoints.clear();
+    for (int tile = destTile; tile != startTile; tile = context.getParent(tile)) {
+        waypoints.push_back(tile);
+    }
+    waypoints.push_back(startTile);
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    // every leg is as long as its Manhattan distance, so the tiles of each
+    // go straight into their slots
+    path.reset(width, context.getG(destTile) + 1);
+    path.set(0, startTile);
+
+    int first = 0;
+    for (size_t i = 1; i < waypoints.size(); i++) {
+        writeLeg(waypoints[i - 1], waypoints[i], first, sweepState, path);
+        first += manhattan(waypoints[i - 1], waypoints[i], width);
+    }
+    return true;
+}
+
+std::vector<Node> SubgoalGraph::findPath(const Map& map, const Node& start, const Node& dest) const
+{
+    TilePath path;
+    findPath(map, start, dest, defaultContext, path);
+    return toNodes(path);
+}
+
+int SubgoalGraph::getSubgoalCount() const
+{
+    int count = 0;
+    for (uint8_t s : isSubgoal) count += s;
+    return count;
+}
+
+int SubgoalGraph::getEdgeCount() const
+{
+    // every link is stored at both ends
+    size_t count = 0;
+    for (const std::vector<int>& e : edges) count += e.size();
+    return (int)(count / 2);
+}
+
+bool subgoalSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path)
+{
+    const SubgoalGraph* graph = theMap.getSubgoals();
+    if (!graph || !graph->isCurrent(theMap)) return aStar(theMap, start, dest, context, path);
+
+    return graph->findPath(theMap, start, dest, context, path);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "AStarSearch.h"
+#include "Map.h"
+#include "SearchContext.h"
+#include "TilePath.h"
+#include "WalkBits.h"
+
+// Simple subgoal graph. Subgoals are the open tiles at convex wall corners:
+// diagonal to a wall tile, with both tiles between them open. A shortest
+// path only has to turn back on itself at one of them, so the stretches in
+// between are h-reachable: some path as long as their Manhattan distance
+// joins them.
+//
+// Each subgoal is linked to the subgoals directly h-reachable from it,
+// i.e. without passing another one on the way. A query links the start and
+// dest to the graph the same way, runs A* over those few nodes, and only
+// then turns each leg into tiles. In a maze of long corridors that's a
+// handful of nodes instead of every corridor tile.
+//
+// Attach it with Map::setSubgoals(); SearchMode::Subgoal then uses it.
+// Breaking a tile re-checks the corners around it and relinks only the
+// subgoals that can see that spot.
+class SubgoalGraph {
+public:
+    // About half a second to build at the limit; bigger maps get no graph
+    // and SearchMode::Subgoal runs aStar() instead
+    static const int MAX_TILES = 1 << 20;
+
+    // Full rebuild for the current map
+    void build(const Map& map);
+
+    // Catch up with tiles changed since the last build or update
+    void update(const Map& map);
+
+    // Graph describes the map as it is now
+    bool isCurrent(const Map& map) const
+    {
+        return !isSubgoal.empty() && version == map.getVersion();
+    }
+
+    // Same contract as aStar(): a shortest tile-by-tile path, or false (and
+    // an empty path) if there is none
+    bool findPath(const Map& map, const Node& start, const Node& dest, SearchContext& context, TilePath& path) const;
+    std::vector<Node> findPath(const Map& map, const Node& start, const Node& dest) const;
+
+    int getSubgoalCount() const;
+    int getEdgeCount() const;
+
+private:
+    // Tiles reached going only toward (qx, qy) from (ox, oy), within the box
+    // out to (endX, endY), into state (row by row from the origin). Subgoals
+    // reached, and stopTile, are added to *found if it's given. With
+    // stopAtSubgoals they end the sweep where they are.
+    void sweep(int ox, int oy, int qx, int qy, int endX, int endY, bool stopAtSubgoals, int stopTile,
+        std::vector<uint8_t>& state, std::vector<int>* found) const;
+
+    // Subgoals (and dest, if given) directly h-reachable from tile, sorted
+    void directlyReachable(int tile, int destTile, std::vector<uint8_t>& state, std::vector<int>& out) const;
+
+    // Write the tiles of an h-reachable leg into path after index first,
+    // where from already is
+    void writeLeg(int from, int to, int first, std::vector<uint8_t>& state, TilePath& path) const;
+
+    bool cornerAt(int x, int y) const;
+
+    bool open(int x, int y) const
+    {
+        return x >= 0 && y >= 0 && x < width && y < height && walk.get(x, y);
+    }
+
+    WalkBits walk;
+    unsigned int version = 0;
+    int width = 0;
+    int height = 0;
+
+    std::vector<uint8_t> isSubgoal;
+
+    // edges[tile] for subgoal tiles, empty for the rest
+    std::vector<std::vector<int>> edges;
+};
+
+// Shortest path through the map's subgoal graph (Map::setSubgoals), or
+// aStar() if it has none that is current
+bool subgoalSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path);
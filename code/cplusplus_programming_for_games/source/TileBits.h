@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "TilePath.h"
+
+// One bit per tile index (y * width + x): a set of tiles, such as the ones
+// a path crosses. A 32x24 map fits in 12 words.
+class TileBits {
+public:
+    // Size for tileCount tiles, all clear
+    void resize(int tileCount)
+    {
+        words.assign((tileCount + 63) / 64, 0);
+    }
+
+    void clear()
+    {
+        words.assign(words.size(), 0);
+    }
+
+    bool get(int tile) const
+    {
+        return (words[tile >> 6] >> (tile & 63)) & 1;
+    }
+
+    void set(int tile)
+    {
+        words[tile >> 6] |= (uint64_t)1 << (tile & 63);
+    }
+
+    // Exactly the tiles still ahead on path
+    void assign(const TilePath& path, int tileCount)
+    {
+        if ((int)words.size() != (tileCount + 63) / 64) resize(tileCount);
+        else clear();
+
+        for (int i = 0; i < path.size(); i++) set(path.tileAt(i));
+    }
+
+    // Is any tile of the w x h rectangle at (x, y) in the set?
+    bool anyInRect(int x, int y, int w, int h, int width) const
+    {
+        for (int ty = y; ty < y + h; ty++) {
+            for (int tx = x; tx < x + w; tx++) {
+                if (get(ty * width + tx)) return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::vector<uint64_t> words;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+// A path as tile indices (y * width + x) from start to goal, plus a cursor
+// marking how far along it the owner has walked. 4 bytes a tile instead of
+// a 28-byte Node, and consuming a step just moves the cursor.
+//
+// The owner keeps one TilePath and lets each search write into it; the
+// storage is reused, so once it has grown to the longest path seen no
+// further allocation happens.
+//
+// toNodes() / assignNodes() in AStarSearch.h convert to and from vector<Node>.
+class TilePath {
+public:
+    void clear()
+    {
+        tiles.clear();
+        cursor = 0;
+    }
+
+    // Size for length tiles on a map width tiles wide, cursor at the start.
+    // Writers then fill every slot with set().
+    void reset(int mapWidth, int length)
+    {
+        width = mapWidth;
+        tiles.resize(length);
+        cursor = 0;
+    }
+
+    void set(int i, int tile) { tiles[i] = tile; }
+
+    // Number of tiles including any already walked
+    int length() const { return (int)tiles.size(); }
+
+    // Tiles not yet walked
+    bool empty() const { return cursor >= (int)tiles.size(); }
+    int size() const { return (int)tiles.size() - cursor; }
+
+    // i-th tile still ahead, 0 being the next one
+    int tileAt(int i) const { return tiles[cursor + i]; }
+    int xAt(int i) const { return tiles[cursor + i] % width; }
+    int yAt(int i) const { return tiles[cursor + i] / width; }
+
+    int frontX() const { return xAt(0); }
+    int frontY() const { return yAt(0); }
+    int backTile() const { return tiles.back(); }
+
+    // The next tile has been reached
+    void advance() { cursor++; }
+
+    // Step past the next tile if it is (x, y), e.g. the searcher's own tile
+    void skipIfAt(int x, int y)
+    {
+        if (!empty() && frontX() == x && frontY() == y) cursor++;
+    }
+
+    int getWidth() const { return width; }
+
+    // Add a tile after the goal, e.g. to follow a goal that moved one step
+    void append(int tile) { tiles.push_back(tile); }
+
+    // Keep only the next count tiles
+    void truncate(int count) { tiles.resize(cursor + count); }
+
+    // Copy count tile indices, reusing this path's storage
+    void assign(int mapWidth, const int* first, int count)
+    {
+        width = mapWidth;
+        tiles.assign(first, first + count);
+        cursor = 0;
+    }
+
+    // Copy the tiles still ahead of another path, less the first skip
+    void assignRemaining(const TilePath& other, int skip = 0)
+    {
+        assign(other.width, other.tiles.data() + other.cursor + skip, other.size() - skip);
+    }
+
+private:
+    std::vector<int> tiles;
+    int cursor = 0;
+    int width = 0;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One bit per tile, set where the tile can be walked on.
+// Each row is a run of 64-bit words (bit x & 63 of word x / 64). Rows are
+// padded so their last bit is always clear, and there is an empty guard row
+// above and below the map. That lets whole-grid shift kernels read one word
+// to either side, or one row up or down, without bounds checks.
+class WalkBits {
+public:
+    void resize(int newWidth, int newHeight)
+    {
+        width = newWidth;
+        height = newHeight;
+        wordsPerRow = newWidth / 64 + 1;
+        words.assign((size_t)(height + 2) * wordsPerRow, 0);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getWordsPerRow() const { return wordsPerRow; }
+
+    // Words including the guard rows
+    int getWordCount() const { return (int)words.size(); }
+
+    // Offset of the first word of row y (guard rows are y = -1 and y = height)
+    int rowOffset(int y) const { return (y + 1) * wordsPerRow; }
+
+    bool inBounds(int x, int y) const
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    // (x, y) must be in bounds
+    bool get(int x, int y) const
+    {
+        return (words[rowOffset(y) + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    void set(int x, int y, bool walkable)
+    {
+        uint64_t& w = words[rowOffset(y) + (x >> 6)];
+        const uint64_t bit = (uint64_t)1 << (x & 63);
+
+        if (walkable) w |= bit;
+        else w &= ~bit;
+    }
+
+    const uint64_t* data() const { return words.data(); }
+
+private:
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> words;
+};
@@ -0,0 +1,218 @@
+#include "Wavefront.h"
+
+#include <algorithm>
+
+// The AVX2 kernel is built on any x86 compiler and picked at runtime, so
+// the game needs no /arch:AVX2 and still runs on CPUs without it
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define WAVEFRONT_AVX2
+#define AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define WAVEFRONT_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#if defined(WAVEFRONT_AVX2)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static int lowestBit(uint64_t w)
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, w);
+    return (int)bit;
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+// next[i] = tiles next to frontier[i] that are walkable and not yet visited,
+// for words [begin, end). Left/right neighbours come from shifting the word
+// and carrying the edge bit in from the word beside it; row padding and the
+// guard rows are always clear, so nothing leaks between rows.
+static void expandWordsScalar(const uint64_t* frontier, const uint64_t* walk, const uint64_t* visited,
+    uint64_t* next, int wordsPerRow, int begin, int end)
+{
+    for (int i = begin; i < end; i++) {
+        uint64_t f = frontier[i];
+        uint64_t grown = frontier[i - wordsPerRow] | frontier[i + wordsPerRow]
+            | (f << 1) | (f >> 1)
+            | (frontier[i - 1] >> 63) | (frontier[i + 1] << 63);
+
+        next[i] = grown & walk[i] & ~visited[i];
+    }
+}
+
+#if defined(WAVEFRONT_AVX2)
+
+// The same four words at a time
+AVX2_TARGET static void expandWordsAvx2(const uint64_t* frontier, const uint64_t* walk, const uint64_t* visited,
+    uint64_t* next, int wordsPerRow, int begin, int end)
+{
+    int i = begin;
+
+    for (; i + 4 <= end; i += 4) {
+        __m256i f = _mm256_loadu_si256((const __m256i*)(frontier + i));
+        __m256i left = _mm256_loadu_si256((const __m256i*)(frontier + i - 1));
+        __m256i right = _mm256_loadu_si256((const __m256i*)(frontier + i + 1));
+        __m256i up = _mm256_loadu_si256((const __m256i*)(frontier + i - wordsPerRow));
+        __m256i down = _mm256_loadu_si256((const __m256i*)(frontier + i + wordsPerRow));
+
+        __m256i grown = _mm256_or_si256(up, down);
+        grown = _mm256_or_si256(grown, _mm256_slli_epi64(f, 1));
+        grown = _mm256_or_si256(grown, _mm256_srli_epi64(f, 1));
+        grown = _mm256_or_si256(grown, _mm256_srli_epi64(left, 63));
+        grown = _mm256_or_si256(grown, _mm256_slli_epi64(right, 63));
+
+        __m256i w = _mm256_loadu_si256((const __m256i*)(walk + i));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(visited + i));
+        grown = _mm256_andnot_si256(v, _mm256_and_si256(grown, w));
+
+        _mm256_storeu_si256((__m256i*)(next + i), grown);
+    }
+
+    expandWordsScalar(frontier, walk, visited, next, wordsPerRow, i, end);
+}
+
+// The CPU has AVX2 and the OS saves the YMM registers on a context switch
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+
+    // XMM and YMM state both enabled
+    if ((_xgetbv(0) & 6) != 6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+static void expandWords(const uint64_t* frontier, const uint64_t* walk, const uint64_t* visited,
+    uint64_t* next, int wordsPerRow, int begin, int end)
+{
+#if defined(WAVEFRONT_AVX2)
+    static const bool avx2 = cpuHasAvx2();
+    if (avx2) {
+        expandWordsAvx2(frontier, walk, visited, next, wordsPerRow, begin, end);
+        return;
+    }
+#endif
+
+    expandWordsScalar(frontier, walk, visited, next, wordsPerRow, begin, end);
+}
+
+bool Wavefront::begin(const WalkBits& walk, int startX, int startY)
+{
+    lastSteps = 0;
+
+    const int count = walk.getWordCount();
+    frontier.assign(count, 0);
+    next.assign(count, 0);
+    visited.assign(count, 0);
+
+    if (!walk.inBounds(startX, startY) || !walk.get(startX, startY)) return false;
+
+    const int w = walk.rowOffset(startY) + (startX >> 6);
+    frontier[w] = (uint64_t)1 << (startX & 63);
+    visited[w] = frontier[w];
+    frontierBegin = w;
+    frontierEnd = w + 1;
+    return true;
+}
+
+bool Wavefront::step(const WalkBits& walk)
+{
+    const int wordsPerRow = walk.getWordsPerRow();
+
+    // Only the rows around the current frontier can change
+    const int begin = std::max(frontierBegin - wordsPerRow, wordsPerRow);
+    const int end = std::min(frontierEnd + wordsPerRow, walk.getWordCount() - wordsPerRow);
+
+    expandWords(frontier.data(), walk.data(), visited.data(), next.data(), wordsPerRow, begin, end);
+
+    int first = end;
+    int last = begin - 1;
+    for (int i = begin; i < end; i++) {
+        if (next[i]) {
+            visited[i] |= next[i];
+            if (first == end) first = i;
+            last = i;
+        }
+    }
+
+    std::fill(frontier.begin() + frontierBegin, frontier.begin() + frontierEnd, 0);
+    frontier.swap(next);
+
+    if (first == end) {
+        frontierBegin = frontierEnd = 0;
+        return false;
+    }
+
+    frontierBegin = first;
+    frontierEnd = last + 1;
+
+    lastSteps++;
+    return true;
+}
+
+int Wavefront::distance(const WalkBits& walk, int startX, int startY, int goalX, int goalY, int maxSteps)
+{
+    if (!begin(walk, startX, startY)) return -1;
+    if (!walk.inBounds(goalX, goalY) || !walk.get(goalX, goalY)) return -1;
+
+    const int goalWord = walk.rowOffset(goalY) + (goalX >> 6);
+    const uint64_t goalBit = (uint64_t)1 << (goalX & 63);
+
+    while (!(visited[goalWord] & goalBit)) {
+        if (lastSteps == maxSteps) return -1;
+        if (!step(walk)) return -1;
+    }
+    return lastSteps;
+}
+
+void Wavefront::distances(const WalkBits& walk, int startX, int startY, Grid<int>& result)
+{
+    const int width = walk.getWidth();
+    const int wordsPerRow = walk.getWordsPerRow();
+
+    if (result.getWidth() != width || result.getHeight() != walk.getHeight()) {
+        result.resize(width, walk.getHeight(), -1);
+    }
+    else {
+        result.fill(-1);
+    }
+
+    if (!begin(walk, startX, startY)) return;
+
+    // Every bit in the frontier after n steps is a tile n steps away
+    do {
+        for (int i = frontierBegin; i < frontierEnd; i++) {
+            uint64_t bits = frontier[i];
+            const int y = i / wordsPerRow - 1;
+            const int x0 = (i % wordsPerRow) * 64;
+
+            while (bits) {
+                result.at(x0 + lowestBit(bits), y) = lastSteps;
+                bits &= bits - 1;
+            }
+        }
+    } while (step(walk));
+}
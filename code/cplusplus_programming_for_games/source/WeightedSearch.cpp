@@ -0,0 +1,103 @@
+#include "WeightedSearch.h"
+
+static thread_local SearchContext weightedContext;
+
+// Walk parents back from destTile. g is a cost, not a step count, so count
+// the steps first and then fill the path from the back.
+static void makeWeightedPath(const SearchContext& context, int destTile, TilePath& path)
+{
+	int length = 1;
+	for (int tile = destTile; context.getParent(tile) != tile; tile = context.getParent(tile)) {
+		length++;
+	}
+
+	path.reset(context.getWidth(), length);
+
+	int tile = destTile;
+	for (int i = length - 1; i >= 0; i--) {
+		path.set(i, tile);
+		tile = context.getParent(tile);
+	}
+}
+
+// Offer neighbour (nx, ny) a route through tile
+static void relaxWeighted(SearchContext& context, const Map& theMap, int tile, int nx, int ny, const Node& dest)
+{
+	const int cost = theMap.getMoveCost(nx, ny);
+	if (cost == 0) return;
+
+	const int next = ny * context.getWidth() + nx;
+	if (context.isClosed(next)) return;
+
+	const int32_t gNew = context.getG(tile) + cost;
+
+	if (!context.isSeen(next) || context.getG(next) > gNew) {
+		// Manhattan times the cheapest move cost (1) never overestimates
+		const int hNew = abs(nx - dest.x) + abs(ny - dest.y);
+
+		context.setNode(next, gNew, tile);
+		context.buckets.push(next, gNew + hNew);
+	}
+}
+
+vector<Node> dialSearch(const Map& theMap, const Node& start, const Node& dest)
+{
+	TilePath path;
+	dialSearch(theMap, start, dest, weightedContext, path);
+	return toNodes(path);
+}
+
+bool dialSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path)
+{
+	path.clear();
+
+	if (theMap.getMoveCost(dest.x, dest.y) == 0) {
+		return false;
+	}
+
+	if (isDestination(start.x, start.y, dest)) {
+		return false;
+	}
+
+	const int width = theMap.getWidth();
+	context.begin(width, theMap.getHeight());
+
+	// a key can be at most one move cost plus one (h shrinking by 1) above
+	// the key it was expanded from
+	context.buckets.reset(Map::MAX_MOVE_COST + 2);
+
+	const int startTile = start.y * width + start.x;
+	const int destTile = dest.y * width + dest.x;
+	context.setNode(startTile, 0, startTile);
+	context.buckets.push(startTile, abs(start.x - dest.x) + abs(start.y - dest.y));
+
+	bool found = false;
+
+	while (!context.buckets.empty()) {
+		const int tile = context.buckets.pop();
+
+		// left behind when a cheaper route to the tile was queued
+		if (context.isClosed(tile)) continue;
+
+		context.close(tile);
+
+		if (tile == destTile) {
+			found = true;
+			break;
+		}
+
+		const int x = tile % width;
+		const int y = tile / width;
+
+		//checks surrounding: up, right, down, left
+		relaxWeighted(context, theMap, tile, x, y - 1, dest);
+		relaxWeighted(context, theMap, tile, x + 1, y, dest);
+		relaxWeighted(context, theMap, tile, x, y + 1, dest);
+		relaxWeighted(context, theMap, tile, x - 1, y, dest);
+	}
+
+	if (found) {
+		makeWeightedPath(context, destTile, path);
+	}
+	return found;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <vector>
+#include "AStarSearch.h"
+
+using namespace std;
+
+// Cheapest route by Map::getMoveCost() rather than fewest steps: floor costs
+// 1, breakable tiles cost Map::BREAKABLE_COST (the time to smash through)
+// and walls can't be entered. So an enemy goes through a breakable when the
+// way round is longer than that, and around it otherwise.
+//
+// Costs are small integers, so the open list is a BucketQueue (Dial's
+// algorithm) rather than a heap: push and pop are O(1).
+// Breakable tiles are passable here, so there's no region check.
+vector<Node> dialSearch(const Map& theMap, const Node& start, const Node& dest);
+bool dialSearch(const Map& theMap, const Node& start, const Node& dest, SearchContext& context, TilePath& path);